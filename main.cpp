@@ -10,29 +10,63 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
 #include <cmath>
 #include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
-#include <execution>
 #include <format>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numbers>
+#include <optional>
 #include <random>
-#include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#ifdef SNOW_HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#endif
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
 #include "font_data.h"
 
 using namespace std::string_literals;
 using json = nlohmann::json;
 
+// Time zones come from the standard library's tzdb where it has one (libstdc++ 14 and later)
+#if defined(__cpp_lib_chrono) && __cpp_lib_chrono >= 201907L
+#define LOCAL_TIME_USE_TZDB 1
+#else
+#define LOCAL_TIME_USE_TZDB 0
+#endif
+
 template <typename T, auto Deleter>
 using SdlPtr = std::unique_ptr<T, std::integral_constant<decltype(Deleter), Deleter>>;
 using WindowPtr = SdlPtr<SDL_Window, SDL_DestroyWindow>;
@@ -40,6 +74,60 @@ using RendererPtr = SdlPtr<SDL_Renderer, SDL_DestroyRenderer>;
 using SurfacePtr = SdlPtr<SDL_Surface, SDL_DestroySurface>;
 using TexturePtr = SdlPtr<SDL_Texture, SDL_DestroyTexture>;
 using FontPtr = SdlPtr<TTF_Font, TTF_CloseFont>;
+using TextEnginePtr = SdlPtr<TTF_TextEngine, TTF_DestroyRendererTextEngine>;
+using TextPtr = SdlPtr<TTF_Text, TTF_DestroyText>;
+
+// Process-wide counters reported by --soak runs; --bench also checks the allocations made per frame. Allocations are
+// only counted in builds with CLOCK_COUNT_ALLOCATIONS (Debug and the digital_clock_v3_bench target).
+namespace Counters {
+#ifdef CLOCK_COUNT_ALLOCATIONS
+inline constexpr bool countsAllocations = true;
+#else
+inline constexpr bool countsAllocations = false;
+#endif
+inline std::atomic<Uint64> allocations{0};
+inline std::atomic<Uint64> texturesCreated{0};
+} // namespace Counters
+
+#ifdef CLOCK_COUNT_ALLOCATIONS
+// Every C++ heap allocation goes through here so it can be counted; the relaxed increment is all it costs. The array
+// and nothrow forms of the standard library call these.
+void *operator new(std::size_t size) {
+  Counters::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  Counters::allocations.fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc() takes only multiples of the alignment
+  const auto align = static_cast<std::size_t>(alignment);
+  if (void *p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return p;
+  throw std::bad_alloc();
+}
+// GCC pairs operator new with operator delete and so takes the free() below for a mismatch once the two are inlined
+// into a caller, although both sides of the pair are defined here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+[[nodiscard]] SDL_Texture *CreateTextureFromSurface(SDL_Renderer *renderer, SDL_Surface *surface) {
+  Counters::texturesCreated.fetch_add(1, std::memory_order_relaxed);
+  return SDL_CreateTextureFromSurface(renderer, surface);
+}
+
+[[nodiscard]] SDL_Texture *CreateTargetTexture(SDL_Renderer *renderer, int w, int h) {
+  Counters::texturesCreated.fetch_add(1, std::memory_order_relaxed);
+  return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+}
 
 namespace Config {
 constexpr int screen_width = 1024;
@@ -47,7 +135,24 @@ constexpr int screen_height = 600;
 constexpr int font_big_size = 382;
 constexpr int font_normal_size = 48;
 constexpr int font_small_size = 32;
+constexpr float time_outline_width = 0.0f; // dark outline around the big digits in logical px, 0 for none
 constexpr int num_snowflakes = 666;
+constexpr bool snow_enabled = true;
+constexpr int num_raindrops = 500; // particle budgets of the other weather, at full intensity
+constexpr int num_drizzle_drops = 700;
+constexpr int num_fog_patches = 24;
+constexpr double snow_sim_hz = 30.0; // snow physics tick, independent of the render rate
+constexpr const char *time_zone = "Europe/Amsterdam"; // IANA name; empty for the system's zone
+constexpr double target_fps = 60.0;
+constexpr bool prefer_vsync = true;
+constexpr bool adaptive_quality = true;
+constexpr double frame_budget_ms = 14.0; // CPU time a 60 Hz frame may take before the governor lowers quality
+constexpr int profile_dump_frames = 600; // frames written per SIGUSR1 dump
+constexpr int bench_default_frames = 2000;
+constexpr int bench_warmup_frames = 60; // frames that may allocate, e.g. to fill the glyph and label caches
+constexpr int bench_data_period = 250;  // frames between changes of the canned weather and advice texts
+constexpr unsigned bench_default_seed = 1;
+constexpr double soak_default_time_scale = 1000.0;
 constexpr const char *AppName = "Digital Clock v3";
 constexpr const char *AppVersion = "0.2.1";
 
@@ -131,6 +236,54 @@ const std::map<int, std::string_view> WEATHER_CODE_RU = {{0, "ясно"},
   if (windspeed <= 20.0) return "шквальный ветер";
   return "ураган";
 }
+// What falls (or hangs) in front of the clock for a WMO weather code, and how much of it. Clouds without
+// precipitation show nothing.
+struct WeatherScene {
+  enum class Kind { Clear, Snow, Rain, Drizzle, Fog };
+  Kind kind = Kind::Snow;
+  float intensity = 1.0f; // share of the particle budget
+};
+[[nodiscard]] WeatherScene getWeatherScene(int weathercode) {
+  using enum WeatherScene::Kind;
+  switch (weathercode) {
+  case 45:
+  case 48:
+    return {Fog, 1.0f};
+  case 51:
+  case 56:
+    return {Drizzle, 0.4f};
+  case 53:
+    return {Drizzle, 0.7f};
+  case 55:
+  case 57:
+    return {Drizzle, 1.0f};
+  case 61:
+  case 66:
+  case 80:
+    return {Rain, 0.4f};
+  case 63:
+  case 81:
+  case 95:
+    return {Rain, 0.7f};
+  case 65:
+  case 67:
+  case 82:
+  case 96:
+  case 99:
+    return {Rain, 1.0f};
+  case 71:
+  case 77:
+  case 85:
+    return {Snow, 0.4f};
+  case 73:
+    return {Snow, 0.7f};
+  case 75:
+  case 86:
+    return {Snow, 1.0f};
+  default:
+    return {Clear, 0.0f};
+  }
+}
 [[nodiscard]] std::string getBasicAdvice(double temperature) {
   if (temperature < -10) {
     return "Наденьте теплую зимнюю куртку, шапку, шарф и теплые ботинки.";
@@ -143,129 +296,3247 @@ const std::map<int, std::string_view> WEATHER_CODE_RU = {{0, "ясно"},
   } else {
     return "Наденьте легкую одежду.";
   }
-}
-constexpr std::array<std::string_view, 7> weekdays = {"воскресенье", "понедельник", "вторник", "среда",
-                                                      "четверг",     "пятница",     "суббота"};
-constexpr std::array<std::string_view, 12> months = {"января", "февраля", "марта",    "апреля",  "мая",    "июня",
-                                                     "июля",   "августа", "сентября", "октября", "ноября", "декабря"};
-} // namespace
+}
+constexpr std::array<std::string_view, 7> weekdays = {"воскресенье", "понедельник", "вторник", "среда",
+                                                      "четверг",     "пятница",     "суббота"};
+constexpr std::array<std::string_view, 12> months = {"января", "февраля", "марта",    "апреля",  "мая",    "июня",
+                                                     "июля",   "августа", "сентября", "октября", "ноября", "декабря"};
+} // namespace
+
+// Civil time in the clock's zone, Config::time_zone. The zone is resolved once; the labels, the LLM prompt and the
+// soak checks all split instants through it, so the date and the time always change over together. Without tzdb
+// support in the standard library the zone is set through TZ for the C library instead.
+class LocalTime {
+public:
+  struct Fields {
+    std::chrono::year_month_day date;
+    std::chrono::weekday weekday;
+    std::chrono::hh_mm_ss<std::chrono::seconds> time;
+    std::chrono::seconds offset; // east of UTC
+  };
+
+  static const LocalTime &Get() {
+    static const LocalTime instance(Config::time_zone);
+    return instance;
+  }
+
+  [[nodiscard]] Fields Split(std::chrono::system_clock::time_point now) const {
+    const auto utc = std::chrono::floor<std::chrono::seconds>(now);
+#if LOCAL_TIME_USE_TZDB
+    const std::chrono::zoned_time zoned{zone, utc};
+    const std::chrono::seconds offset = zoned.get_info().offset;
+#else
+    const std::time_t t = std::chrono::system_clock::to_time_t(now);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    const std::chrono::seconds offset{tm.tm_gmtoff};
+#endif
+    const auto local = utc + offset;
+    const auto days = std::chrono::floor<std::chrono::days>(local);
+    return {std::chrono::year_month_day{days}, std::chrono::weekday{days},
+            std::chrono::hh_mm_ss<std::chrono::seconds>{local - days}, offset};
+  }
+
+  [[nodiscard]] const std::string &Name() const { return name; }
+
+private:
+  explicit LocalTime(const char *zoneName) {
+#if LOCAL_TIME_USE_TZDB
+    try {
+      zone = *zoneName ? std::chrono::locate_zone(zoneName) : std::chrono::current_zone();
+    } catch (const std::runtime_error &e) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unknown time zone %s, using the system's: %s", zoneName, e.what());
+      zone = std::chrono::current_zone();
+    }
+    name = zone->name();
+#else
+    if (*zoneName) setenv("TZ", zoneName, 1);
+    tzset();
+    name = *zoneName ? zoneName : "system";
+#endif
+  }
+
+#if LOCAL_TIME_USE_TZDB
+  const std::chrono::time_zone *zone = nullptr;
+#endif
+  std::string name;
+};
+
+// These replace the contents of `out` but keep its capacity, so a reused buffer formats without allocating. A time
+// and date shown together are formatted from one Split(), so they can't straddle midnight.
+void formatCurrentTime(std::string &out, const LocalTime::Fields &local) {
+  out.clear();
+  std::format_to(std::back_inserter(out), "{}:{:02}", local.time.hours().count(), local.time.minutes().count());
+}
+
+void formatCurrentDate(std::string &out, const LocalTime::Fields &local) {
+  out.clear();
+  std::format_to(std::back_inserter(out), "{}, {} {} {} года", weekdays[local.weekday.c_encoding()],
+                 static_cast<unsigned>(local.date.day()), months[static_cast<unsigned>(local.date.month()) - 1],
+                 static_cast<int>(local.date.year()));
+}
+
+std::string getCurrentTime(const LocalTime::Fields &local) {
+  std::string time;
+  formatCurrentTime(time, local);
+  return time;
+}
+
+std::string getCurrentDate(const LocalTime::Fields &local) {
+  std::string date;
+  formatCurrentDate(date, local);
+  return date;
+}
+
+// The app's single source of wall-clock time. By default it simply is the system clock; soak runs scale it (e.g.
+// 1000x real time) and --bench steps it by hand, so minute flips, fetch cycles and midnights arrive on demand.
+// Frame pacing stays on real time: the display refreshes at the same rate whatever the simulated date is.
+class VirtualClock {
+public:
+  using WallTime = std::chrono::system_clock::time_point;
+  enum class Mode { Real, Scaled, Manual };
+
+  // Call these before any other thread reads the clock
+  void StartScaled(WallTime origin, double factor) {
+    mode = Mode::Scaled;
+    wallOrigin = origin;
+    steadyOrigin = std::chrono::steady_clock::now();
+    scale = factor;
+  }
+  void StartManual(WallTime origin) {
+    mode = Mode::Manual;
+    wallOrigin = origin;
+    scale = 1.0;
+  }
+
+  // Manual mode only; called from the main thread while other threads may read Now()
+  void Advance(std::chrono::nanoseconds step) { manualOffsetNs.fetch_add(step.count(), std::memory_order_relaxed); }
+
+  [[nodiscard]] WallTime Now() const {
+    switch (mode) {
+    case Mode::Real:
+      return std::chrono::system_clock::now();
+    case Mode::Scaled: {
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - steadyOrigin;
+      return wallOrigin + std::chrono::duration_cast<WallTime::duration>(elapsed * scale);
+    }
+    case Mode::Manual:
+      return wallOrigin + std::chrono::nanoseconds(manualOffsetNs.load(std::memory_order_relaxed));
+    }
+    return wallOrigin;
+  }
+
+  [[nodiscard]] Mode GetMode() const { return mode; }
+
+  // How long to really wait for `d` of clock time to pass. A manual clock only moves when stepped, so poll it.
+  [[nodiscard]] std::chrono::milliseconds RealDuration(WallTime::duration d) const {
+    if (mode == Mode::Manual) return std::chrono::milliseconds(10);
+    return std::chrono::ceil<std::chrono::milliseconds>(std::chrono::duration<double, std::nano>(d) / scale);
+  }
+
+  // Sleeps until the clock reaches `deadline`. Returns false if stopped first.
+  bool SleepUntil(std::stop_token stopToken, WallTime deadline) const {
+    std::mutex sleepMutex;             // We use a dummy mutex because the condition_variable's wait_for requires
+    std::unique_lock lock(sleepMutex); // a lock to wait on
+    std::condition_variable_any cv;
+    while (!stopToken.stop_requested()) {
+      auto remaining = deadline - Now();
+      if (remaining <= WallTime::duration::zero()) return true;
+      cv.wait_for(lock, stopToken, RealDuration(remaining), [&stopToken] { return stopToken.stop_requested(); });
+    }
+    return false;
+  }
+
+  template <typename Rep, typename Period>
+  bool SleepFor(std::stop_token stopToken, std::chrono::duration<Rep, Period> d) const {
+    return SleepUntil(stopToken, Now() + std::chrono::duration_cast<WallTime::duration>(d));
+  }
+
+private:
+  Mode mode = Mode::Real;
+  WallTime wallOrigin;
+  std::chrono::steady_clock::time_point steadyOrigin;
+  double scale = 1.0;
+  std::atomic<std::int64_t> manualOffsetNs{0};
+};
+
+// Formats the time and date strings once per minute instead of on every frame. With the real clock a thread waits on a
+// timerfd armed for the next minute boundary in absolute CLOCK_REALTIME; TFD_TIMER_CANCEL_ON_SET also wakes it when
+// the system clock is set (NTP steps, manual changes), so jumps either way show at once. A virtual clock never jumps,
+// so under --bench and --soak the main loop simply checks it against the next boundary.
+class MinuteClock {
+public:
+  // Every buffer has room for any time and date, so neither formatting nor copying them allocates
+  MinuteClock() {
+    for (std::string *buffer : {&currentTime, &currentDate, &nextTime, &nextDate, &shownTime, &shownDate}) {
+      buffer->reserve(Capacity);
+    }
+  }
+  MinuteClock(const MinuteClock &) = delete;
+  MinuteClock &operator=(const MinuteClock &) = delete;
+
+  ~MinuteClock() {
+    if (thread.joinable()) {
+      thread.request_stop();
+      thread.join();
+    }
+    if (timerFd >= 0) close(timerFd);
+    if (stopFd >= 0) close(stopFd);
+  }
+
+  // Call once the clock's mode is set. `onChange` is called from the timer thread after each update.
+  void Start(const VirtualClock &source, std::function<void()> onChange) {
+    clock = &source;
+    changed = std::move(onChange);
+    Refresh();
+    if (clock->GetMode() != VirtualClock::Mode::Real) return;
+    timerFd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (timerFd < 0 || stopFd < 0) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create minute timer, polling the clock: %s",
+                  std::strerror(errno));
+      return;
+    }
+    thread = std::jthread([this](std::stop_token stopToken) { Run(stopToken); });
+  }
+
+  // Main thread. Takes over the latest strings and returns true when they changed since the last call; between minute
+  // boundaries it is an atomic load.
+  bool Poll() {
+    if (!thread.joinable() && clock && clock->Now() >= nextBoundary) Refresh();
+    if (generation.load(std::memory_order_acquire) == seenGeneration) return false;
+    std::lock_guard lock(mutex);
+    shownTime = currentTime;
+    shownDate = currentDate;
+    shownMinute = currentMinute;
+    seenGeneration = generation.load(std::memory_order_relaxed);
+    return true;
+  }
+
+  // Main thread; as of the last Poll()
+  [[nodiscard]] const std::string &Time() const { return shownTime; }
+  [[nodiscard]] const std::string &Date() const { return shownDate; }
+  [[nodiscard]] VirtualClock::WallTime Minute() const { return shownMinute; } // the one Time() and Date() show
+
+private:
+  // Formats outside the lock. `nextBoundary` belongs to the timer thread when there is one, else to the main thread.
+  void Refresh() {
+    const auto now = clock->Now();
+    const auto local = LocalTime::Get().Split(now);
+    formatCurrentTime(nextTime, local);
+    formatCurrentDate(nextDate, local);
+    const VirtualClock::WallTime minute = std::chrono::floor<std::chrono::minutes>(now);
+    nextBoundary = minute + std::chrono::minutes(1);
+    std::lock_guard lock(mutex);
+    std::swap(currentTime, nextTime);
+    std::swap(currentDate, nextDate);
+    currentMinute = minute;
+    generation.fetch_add(1, std::memory_order_release);
+  }
+
+  void Run(std::stop_token stopToken) {
+    std::stop_callback wake(stopToken, [this] {
+      const Uint64 one = 1;
+      [[maybe_unused]] auto written = write(stopFd, &one, sizeof(one));
+    });
+    while (!stopToken.stop_requested()) {
+      itimerspec spec{};
+      spec.it_value.tv_sec = std::chrono::system_clock::to_time_t(nextBoundary);
+      if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) < 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't arm minute timer: %s", std::strerror(errno));
+        clock->SleepUntil(stopToken, nextBoundary);
+      } else {
+        std::array<pollfd, 2> fds{{{timerFd, POLLIN, 0}, {stopFd, POLLIN, 0}}};
+        if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) break;
+        if (stopToken.stop_requested()) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+        // Either the boundary passed, or the read fails with ECANCELED because the clock was set. Both mean the
+        // strings are redone and the timer is armed again.
+        Uint64 expirations;
+        [[maybe_unused]] auto got = read(timerFd, &expirations, sizeof(expirations));
+      }
+      Refresh();
+      if (changed) changed();
+    }
+  }
+
+  const VirtualClock *clock = nullptr;
+  std::function<void()> changed;
+  std::mutex mutex;
+  static constexpr size_t Capacity = 128; // bytes, for the longest date in Cyrillic with room to spare
+
+  std::string currentTime, currentDate; // guarded by the mutex
+  std::string nextTime, nextDate;       // Refresh() only
+  std::string shownTime, shownDate;     // main thread only
+  VirtualClock::WallTime currentMinute, shownMinute;
+  std::atomic<Uint64> generation{0};
+  Uint64 seenGeneration = 0;
+  VirtualClock::WallTime nextBoundary;
+  int timerFd = -1;
+  int stopFd = -1;
+  std::jthread thread; // last, so it is joined before anything it uses is destroyed
+};
+
+// Thin wrappers over the vector ISA chosen at build time (AVX when the compiler targets it, otherwise SSE2 on x86 and
+// NEON on ARM), so the snow kernels are written once. `Scalar` does the same arithmetic one lane at a time.
+namespace Simd {
+struct Scalar {
+  using V = float;
+  using M = bool;
+  static constexpr size_t Width = 1;
+  static constexpr const char *Name = "scalar";
+
+  static V Load(const float *p) { return *p; }
+  static void Store(float *p, V v) { *p = v; }
+  static V Set(float f) { return f; }
+  static V Add(V a, V b) { return a + b; }
+  static V Sub(V a, V b) { return a - b; }
+  static V Mul(V a, V b) { return a * b; }
+  static M Gt(V a, V b) { return a > b; }
+  static M Lt(V a, V b) { return a < b; }
+  static M Or(M a, M b) { return a || b; }
+  static M And(M a, M b) { return a && b; }
+  static bool Any(M m) { return m; }
+  static V Select(M m, V a, V b) { return m ? a : b; }
+  static V Round(V a) { return std::nearbyint(a); }
+  static V Trunc(V a) { return std::trunc(a); }
+};
+
+#if defined(__AVX__)
+struct Avx {
+  using V = __m256;
+  using M = __m256;
+  static constexpr size_t Width = 8;
+  static constexpr const char *Name = "avx";
+
+  static V Load(const float *p) { return _mm256_loadu_ps(p); }
+  static void Store(float *p, V v) { _mm256_storeu_ps(p, v); }
+  static V Set(float f) { return _mm256_set1_ps(f); }
+  static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+  static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+  static M Gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static M Lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+  static M And(M a, M b) { return _mm256_and_ps(a, b); }
+  static bool Any(M m) { return _mm256_movemask_ps(m) != 0; }
+  static V Select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+  static V Round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+  static V Trunc(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+};
+#endif
+
+#if defined(__SSE2__)
+struct Sse2 {
+  using V = __m128;
+  using M = __m128;
+  static constexpr size_t Width = 4;
+  static constexpr const char *Name = "sse2";
+
+  static V Load(const float *p) { return _mm_loadu_ps(p); }
+  static void Store(float *p, V v) { _mm_storeu_ps(p, v); }
+  static V Set(float f) { return _mm_set1_ps(f); }
+  static V Add(V a, V b) { return _mm_add_ps(a, b); }
+  static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+  static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+  static M Gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+  static M Lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+  static M Or(M a, M b) { return _mm_or_ps(a, b); }
+  static M And(M a, M b) { return _mm_and_ps(a, b); }
+  static bool Any(M m) { return _mm_movemask_ps(m) != 0; }
+  static V Select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+  // Both conversions are exact for the magnitudes the kernels produce (well below 2^31)
+  static V Round(V a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+  static V Trunc(V a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+};
+#endif
+
+#if defined(__ARM_NEON)
+// Sticks to ARMv7 NEON (the Pi build targets cortex-a7): no vrndnq/vdivq, and no fused multiply-add so results
+// match the scalar code
+struct Neon {
+  using V = float32x4_t;
+  using M = uint32x4_t;
+  static constexpr size_t Width = 4;
+  static constexpr const char *Name = "neon";
+
+  static V Load(const float *p) { return vld1q_f32(p); }
+  static void Store(float *p, V v) { vst1q_f32(p, v); }
+  static V Set(float f) { return vdupq_n_f32(f); }
+  static V Add(V a, V b) { return vaddq_f32(a, b); }
+  static V Sub(V a, V b) { return vsubq_f32(a, b); }
+  static V Mul(V a, V b) { return vmulq_f32(a, b); }
+  static M Gt(V a, V b) { return vcgtq_f32(a, b); }
+  static M Lt(V a, V b) { return vcltq_f32(a, b); }
+  static M Or(M a, M b) { return vorrq_u32(a, b); }
+  static M And(M a, M b) { return vandq_u32(a, b); }
+  static bool Any(M m) {
+    const uint32x2_t halves = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1)) != 0;
+  }
+  static V Select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+  static V Round(V a) {
+    // Round half away from zero: add +-0.5, then truncate
+    const V half = vbslq_f32(vcltq_f32(a, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+    return vcvtq_f32_s32(vcvtq_s32_f32(vaddq_f32(a, half)));
+  }
+  static V Trunc(V a) { return vcvtq_f32_s32(vcvtq_s32_f32(a)); }
+};
+#endif
+
+#if defined(__AVX__)
+using Native = Avx;
+#elif defined(__SSE2__)
+using Native = Sse2;
+#elif defined(__ARM_NEON)
+using Native = Neon;
+#else
+using Native = Scalar;
+#endif
+
+// Widest vector any build uses; SoA arrays are padded to it so kernels never need a scalar tail
+constexpr size_t MaxWidth = 8;
+
+// Round toward negative infinity, built on Round so it works for every ISA
+template <typename Ops> inline typename Ops::V Floor(typename Ops::V a) {
+  const typename Ops::V r = Ops::Round(a);
+  return Ops::Select(Ops::Gt(r, a), Ops::Sub(r, Ops::Set(1.0f)), r);
+}
+
+// sin(a) to within ~4e-6 of std::sin: reduce to [-pi, pi], fold into [-pi/2, pi/2], then a 9th order odd polynomial
+template <typename Ops> inline typename Ops::V Sin(typename Ops::V a) {
+  using V = typename Ops::V;
+  constexpr float pi = std::numbers::pi_v<float>;
+  const V turns = Ops::Round(Ops::Mul(a, Ops::Set(0.5f / pi)));
+  // 2*pi split in two so the reduction stays accurate for large arguments
+  V r = Ops::Sub(Ops::Sub(a, Ops::Mul(turns, Ops::Set(6.28125f))), Ops::Mul(turns, Ops::Set(1.9353071795864769e-3f)));
+  r = Ops::Select(Ops::Gt(r, Ops::Set(pi / 2)), Ops::Sub(Ops::Set(pi), r), r);
+  r = Ops::Select(Ops::Lt(r, Ops::Set(-pi / 2)), Ops::Sub(Ops::Set(-pi), r), r);
+  const V r2 = Ops::Mul(r, r);
+  V poly = Ops::Set(1.0f / 362880.0f);
+  poly = Ops::Add(Ops::Mul(poly, r2), Ops::Set(-1.0f / 5040.0f));
+  poly = Ops::Add(Ops::Mul(poly, r2), Ops::Set(1.0f / 120.0f));
+  poly = Ops::Add(Ops::Mul(poly, r2), Ops::Set(-1.0f / 6.0f));
+  poly = Ops::Add(Ops::Mul(poly, r2), Ops::Set(1.0f));
+  return Ops::Mul(poly, r);
+}
+} // namespace Simd
+
+// Fork/join pool for data-parallel loops over a few thousand elements. The calling thread works on chunks too, and a
+// dispatch costs one notify plus whatever it takes the workers to wake up, with no allocation.
+class WorkerPool {
+public:
+  explicit WorkerPool(unsigned workers) {
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) threads.emplace_back([this] { Run(); });
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  [[nodiscard]] size_t ThreadCount() const { return threads.size() + 1; }
+
+  // Calls body(begin, end) for consecutive chunks of [0, count) of at most `grain` elements and returns when all of
+  // them are done. Chunks start at multiples of `grain`.
+  template <typename F> void ParallelFor(size_t count, size_t grain, F &&body) {
+    if (count <= grain || threads.empty()) {
+      if (count > 0) body(size_t{0}, count);
+      return;
+    }
+    using Body = std::remove_reference_t<F>;
+    Job job{.count = count,
+            .grain = grain,
+            .context = &body,
+            .invoke = [](void *context, size_t begin, size_t end) { (*static_cast<Body *>(context))(begin, end); }};
+    {
+      std::lock_guard lock(mutex);
+      current = &job;
+      generation++;
+    }
+    wake.notify_all();
+    Work(job);
+
+    // Every chunk has been claimed; wait for the workers still running one. Clearing `current` under the same lock
+    // keeps late wakers from touching the job after it goes out of scope.
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return job.users == 0; });
+    current = nullptr;
+  }
+
+private:
+  struct Job {
+    size_t count;
+    size_t grain;
+    void *context;
+    void (*invoke)(void *context, size_t begin, size_t end);
+    std::atomic<size_t> next{0};
+    int users = 0; // workers inside Work(); guarded by the pool mutex
+  };
+
+  static void Work(Job &job) {
+    for (size_t begin; (begin = job.next.fetch_add(job.grain, std::memory_order_relaxed)) < job.count;) {
+      job.invoke(job.context, begin, std::min(begin + job.grain, job.count));
+    }
+  }
+
+  void Run() {
+    Uint64 seen = 0;
+    while (true) {
+      Job *job;
+      {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        job = current;
+        if (!job) continue;
+        job->users++;
+      }
+      Work(*job);
+      {
+        std::lock_guard lock(mutex);
+        if (--job->users == 0) done.notify_one();
+      }
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  Job *current = nullptr;
+  Uint64 generation = 0;
+  bool stopping = false;
+  std::vector<std::jthread> threads; // last, so the threads are joined before anything they use is destroyed
+};
+
+// Counter-based random numbers: SplitMix64 indexed directly, so draw n is a bijective mix of seed + n * gamma and needs
+// no state from the draws before it. Any draw can be made on any thread, in any order, and the same seed always gives
+// the same numbers. Draws are addressed by a stream (< 256), a key (< 2^24) and a 32-bit counter, packed into n.
+class CounterRng {
+public:
+  CounterRng() = default;
+  explicit CounterRng(Uint64 seed) : seed(Mix(seed)) {}
+
+  [[nodiscard]] Uint64 Bits(Uint32 stream, Uint32 key, Uint32 counter) const {
+    return Mix(seed + ((Uint64{stream} << 56) | (Uint64{key} << 32) | counter) * Gamma);
+  }
+
+  // Uniform in [lo, hi), from the top 24 bits
+  [[nodiscard]] float Uniform(Uint32 stream, Uint32 key, Uint32 counter, float lo = 0.0f, float hi = 1.0f) const {
+    return lo + (hi - lo) * static_cast<float>(Bits(stream, key, counter) >> 40) * 0x1p-24f;
+  }
+
+private:
+  static constexpr Uint64 Gamma = 0x9E3779B97F4A7C15ull;
+
+  static Uint64 Mix(Uint64 z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  Uint64 seed = 0;
+};
+
+// Snow lying on the label tops and the bottom of the screen: a height-map with one column per ColumnWidth pixels.
+// The surface it lies on is rebuilt from the labels' column tables when a label changes; the depth on top of it grows
+// as flakes land and melts and settles in vectorized passes over all columns.
+class SnowCover {
+public:
+  static constexpr float ColumnWidth = 2.0f;
+
+  // Something snow can settle on: for each pixel column of `rect`, the offset of its first opaque row, or infinity
+  struct Obstacle {
+    SDL_FRect rect;
+    std::span<const float> columnTops;
+  };
+
+  // Flakes that landed during a step. Kernels on several threads append to it.
+  struct LandingLog {
+    struct Landing {
+      Uint32 column;
+      float amount; // pixels of depth it adds
+    };
+    std::vector<Landing> items;
+    std::atomic<size_t> count{0};
+
+    void Record(Uint32 column, float amount) {
+      const size_t slot = count.fetch_add(1, std::memory_order_relaxed);
+      if (slot < items.size()) items[slot] = {column, amount};
+    }
+  };
+
+  void Init(float width, float height) {
+    screenHeight = height;
+    columns = static_cast<size_t>(std::ceil(width / ColumnWidth));
+    const size_t padded = (columns + Simd::MaxWidth - 1) / Simd::MaxWidth * Simd::MaxWidth;
+    // One guard column on each side so the neighbour loads of the settle pass stay in bounds. The guards and the
+    // padding up to a whole vector have no surface, which no snow flows onto.
+    surface.assign(padded + 2, -std::numeric_limits<float>::infinity());
+    std::fill_n(surface.begin() + 1, columns, height);
+    depth.assign(padded + 2, 0.0f);
+    nextDepth.assign(padded + 2, 0.0f);
+    ground.assign(padded, height);
+
+    // Only the y coordinates change after this
+    positions.assign(columns * 8, 0.0f);
+    colors.assign(columns * 4, SDL_FColor{0.95f, 0.97f, 1.0f, 0.9f});
+    indices.resize(columns * 6);
+    for (size_t c = 0; c < columns; ++c) {
+      const float left = c * ColumnWidth, right = left + ColumnWidth;
+      std::ranges::copy(std::array{left, 0.0f, right, 0.0f, right, 0.0f, left, 0.0f}, &positions[c * 8]);
+      const int v = static_cast<int>(c * 4);
+      std::ranges::copy(std::array{v, v + 1, v + 2, v + 2, v + 3, v}, &indices[c * 6]);
+    }
+    UpdateGeometry();
+  }
+
+  // Rebuilds the surface from the obstacles. Snow stays where the surface under it didn't move and falls off where it
+  // did, e.g. where a digit changed.
+  void SetObstacles(std::span<const Obstacle> obstacles) {
+    for (size_t c = 0; c < columns; ++c) {
+      float top = screenHeight;
+      for (const Obstacle &o : obstacles) {
+        for (float px = c * ColumnWidth; px < (c + 1) * ColumnWidth; px += 1.0f) {
+          const float local = std::floor(px + 0.5f - o.rect.x);
+          if (local >= 0.0f && local < static_cast<float>(o.columnTops.size())) {
+            top = std::min(top, o.rect.y + o.columnTops[static_cast<size_t>(local)]);
+          }
+        }
+      }
+      if (std::abs(top - surface[c + 1]) > 2.0f) depth[c + 1] = 0.0f;
+      surface[c + 1] = top;
+      ground[c] = top - depth[c + 1];
+    }
+    UpdateGeometry();
+  }
+
+  // What falling flakes collide with, per column
+  [[nodiscard]] const float *Ground() const { return ground.data(); }
+  [[nodiscard]] size_t Columns() const { return columns; }
+  // Whether any snow was left after the last update, i.e. whether updates still change anything
+  [[nodiscard]] bool HasSnow() const { return covered; }
+
+  // Adds the logged landings, then melts and settles the snow for `dt` seconds
+  void Update(LandingLog &log, float dt) {
+    const size_t landed = std::min(log.count.exchange(0, std::memory_order_relaxed), log.items.size());
+    for (size_t k = 0; k < landed; ++k) depth[log.items[k].column + 1] += log.items[k].amount;
+    Settle<Simd::Native>(dt);
+    UpdateGeometry();
+  }
+
+  void Draw(SDL_Renderer *renderer) {
+    if (columns == 0) return;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometryRaw(renderer, nullptr, positions.data(), 2 * sizeof(float), colors.data(), sizeof(SDL_FColor),
+                          nullptr, 0, static_cast<int>(columns * 4), indices.data(), static_cast<int>(columns * 6),
+                          sizeof(int));
+  }
+
+private:
+  static constexpr float MaxDepth = 16.0f;
+  static constexpr float MeltBase = 0.01f; // px/s
+  static constexpr float MeltRate = 0.005f; // fraction of the depth per second, so deep snow melts faster
+  static constexpr float SettleRate = 2.0f; // how fast neighbouring columns even out, per second
+
+  // One melt and settle step over all columns: each column moves towards its neighbours on the same surface, then
+  // melts. Reads `depth`, writes `nextDepth` and `ground`.
+  template <typename Ops> void Settle(float dt) {
+    using V = typename Ops::V;
+    const V zero = Ops::Set(0.0f);
+    const V sameSurface = Ops::Set(1.5f);
+    const V negSameSurface = Ops::Set(-1.5f);
+    const V settle = Ops::Set(std::min(SettleRate * dt, 0.25f)); // <= 0.25 keeps the diffusion stable
+    const V meltBase = Ops::Set(MeltBase * dt);
+    const V meltRate = Ops::Set(1.0f - MeltRate * dt);
+    const V maxDepth = Ops::Set(MaxDepth);
+    auto any = Ops::Gt(zero, zero);
+    for (size_t c = 0; c < ground.size(); c += Ops::Width) {
+      const V d = Ops::Load(&depth[c + 1]);
+      const V s = Ops::Load(&surface[c + 1]);
+      const V toLeft = Ops::Sub(Ops::Load(&surface[c]), s);
+      const V toRight = Ops::Sub(Ops::Load(&surface[c + 2]), s);
+      const auto sameLeft = Ops::And(Ops::Lt(toLeft, sameSurface), Ops::Gt(toLeft, negSameSurface));
+      const auto sameRight = Ops::And(Ops::Lt(toRight, sameSurface), Ops::Gt(toRight, negSameSurface));
+      const V flow = Ops::Add(Ops::Select(sameLeft, Ops::Sub(Ops::Load(&depth[c]), d), zero),
+                              Ops::Select(sameRight, Ops::Sub(Ops::Load(&depth[c + 2]), d), zero));
+      V next = Ops::Sub(Ops::Mul(Ops::Add(d, Ops::Mul(flow, settle)), meltRate), meltBase);
+      next = Ops::Select(Ops::Lt(next, zero), zero, next);
+      next = Ops::Select(Ops::Gt(next, maxDepth), maxDepth, next);
+      any = Ops::Or(any, Ops::Gt(next, zero));
+      Ops::Store(&nextDepth[c + 1], next);
+      Ops::Store(&ground[c], Ops::Sub(s, next));
+    }
+    std::swap(depth, nextDepth);
+    covered = Ops::Any(any);
+  }
+
+  // A quad per column from the top of the snow down to the surface, overlapping it by up to a pixel to cover the
+  // anti-aliased edge of the glyph underneath. Bare columns get an empty quad.
+  void UpdateGeometry() {
+    for (size_t c = 0; c < columns; ++c) {
+      float *quad = &positions[c * 8];
+      quad[1] = quad[3] = ground[c];
+      quad[5] = quad[7] = surface[c + 1] + std::min(depth[c + 1], 1.0f);
+    }
+  }
+
+  float screenHeight = 0.0f;
+  size_t columns = 0;
+  bool covered = false;
+  std::vector<float> surface; // y of what the snow lies on, with guard columns
+  std::vector<float> depth, nextDepth; // with guard columns
+  std::vector<float> ground;           // surface - depth, without guards
+  std::vector<float> positions;
+  std::vector<SDL_FColor> colors;
+  std::vector<int> indices;
+};
+
+class SnowSystem {
+public:
+  void Init(SDL_Renderer *renderer, int width, int height, int count = 200, unsigned seed = std::random_device{}()) {
+    screenWidth = (float)width;
+    screenHeight = (float)height;
+
+    // Without the atlas the flakes are drawn as plain squares
+    atlas.reset();
+    if (SurfacePtr sprites = MakeSpriteAtlas()) {
+      atlas.reset(CreateTextureFromSurface(renderer, sprites.get()));
+    }
+    if (atlas) {
+      SDL_SetTextureBlendMode(atlas.get(), SDL_BLENDMODE_BLEND);
+      SDL_SetTextureScaleMode(atlas.get(), SDL_SCALEMODE_LINEAR);
+    } else {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create snowflake atlas: %s", SDL_GetError());
+    }
+
+    flakeCount = static_cast<size_t>(count);
+    rng = CounterRng(seed);
+
+    // Depths are drawn up front and sorted so that each layer is one contiguous range of slots, drawn far to near.
+    // Every range starts on a SIMD boundary; its padding lanes get real flakes of the layer too, which are simulated
+    // along with the rest but never drawn.
+    std::vector<float> depths(flakeCount);
+    for (size_t k = 0; k < flakeCount; ++k) depths[k] = Random(rng, Stream::Depth, k, 0, 0.2f, 1.0f);
+    std::ranges::sort(depths);
+    size_t slots = 0, first = 0;
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      size_t last = first;
+      while (last < flakeCount && (l + 1 == Layers.size() || depths[last] < Layers[l].maxDepth)) last++;
+      layerRanges[l] = {slots, last - first, last - first};
+      slots += RoundUpToSimd(last - first);
+      first = last;
+    }
+    flakes.Resize(slots);
+    cover.Init(flakeCount > 0 ? screenWidth : 0.0f, screenHeight);
+    // Every simulated flake can land at most once per step
+    landingLog.items.resize(slots * MaxStepsPerUpdate);
+    positions.resize(slots * FloatsPerQuad);
+    points.resize(slots);
+    colors.resize(slots * 4);
+    uvs.resize(slots * FloatsPerQuad);
+    activeCount = flakeCount;
+    stepCounter = 0;
+
+    // Indices, colours and UVs never change; each frame only rewrites `positions` and `points`. The quad layers are
+    // drawn one at a time from their first slot, so they share the indices of the largest one.
+    size_t quads = 0;
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      if (!Layers[l].points) quads = std::max(quads, layerRanges[l].count);
+    }
+    indices.resize(quads * 6);
+    std::vector<int> indexPattern = {0, 1, 2, 2, 3, 0};
+    for (size_t i = 0; i < quads; ++i) {
+      int vStart = static_cast<int>(i * 4);
+      int iStart = static_cast<int>(i * 6);
+      for (int k = 0; k < 6; ++k) {
+        indices[iStart + k] = vStart + indexPattern[k];
+      }
+    }
+    first = 0;
+    for (const LayerRange &range : layerRanges) {
+      for (size_t k = 0; k < RoundUpToSimd(range.count); ++k) {
+        ResetFlake(range.begin + k, depths[first + std::min(k, range.count - 1)]);
+      }
+      first += range.count;
+    }
+
+    // The main thread takes chunks too, so a pool with one thread per remaining core
+    const unsigned cores = std::thread::hardware_concurrency();
+    pool = cores > 1 && flakeCount > ChunkFlakes ? std::make_unique<WorkerPool>(cores - 1) : nullptr;
+    backend = Backend::Simd;
+    calibration = {};
+  }
+
+  // How the step and vertex passes are executed. All of them produce the same frames (the serial one within the
+  // tolerance of the polynomial sine); they differ only in speed, which depends on the flake count and the machine.
+  enum class Backend { Serial, Simd, ThreadPool, Tbb, Count };
+  static constexpr std::array<const char *, static_cast<size_t>(Backend::Count)> BackendNames{"serial", "simd", "pool",
+                                                                                              "tbb"};
+
+  [[nodiscard]] bool IsAvailable(Backend b) const {
+    switch (b) {
+    case Backend::Serial:
+    case Backend::Simd:
+      return true;
+    case Backend::ThreadPool:
+      return pool != nullptr;
+    case Backend::Tbb:
+#ifdef SNOW_HAVE_TBB
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+    }
+  }
+
+  // Forces a backend; calibrated choices no longer apply
+  bool SetBackend(Backend b) {
+    if (!IsAvailable(b)) return false;
+    backend = b;
+    calibration = {};
+    return true;
+  }
+  [[nodiscard]] Backend GetBackend() const { return backend; }
+  [[nodiscard]] const char *GetBackendName() const { return BackendNames[static_cast<size_t>(backend)]; }
+
+  // The fastest backend for around `flakes` active flakes, and the microseconds per simulation step plus vertex pass
+  // each backend took there (0 if not measured)
+  struct CalibrationTier {
+    size_t flakes = 0;
+    Backend best = Backend::Simd;
+    std::array<double, static_cast<size_t>(Backend::Count)> us{};
+  };
+  static constexpr size_t CalibrationTiers = 4; // all flakes, half, a quarter and an eighth of them
+  // Measured by Calibrate(), most flakes first; empty (flakes 0) if not calibrated
+  [[nodiscard]] const std::array<CalibrationTier, CalibrationTiers> &GetCalibration() const { return calibration; }
+
+  // Times every available backend with all flakes active and with halvings of that, so that SetActiveCount() can
+  // switch to the fastest backend for the count the weather and the quality governor leave active. The simulation
+  // state is restored afterwards, so this can run at any point without visibly moving the snow.
+  Backend Calibrate() {
+    calibration = {};
+    if (flakeCount == 0) return backend;
+    const Flakes saved = flakes;
+    const double savedTime = windTimer;
+    const Uint64 savedSteps = stepCounter;
+    const auto savedRanges = layerRanges;
+    const size_t savedActive = activeCount;
+
+    for (size_t t = 0; t < CalibrationTiers && (flakeCount >> t) > 0; ++t) {
+      CalibrationTier &tier = calibration[t];
+      SetLayerCounts(flakeCount >> t);
+      tier.flakes = activeCount;
+      double bestUs = std::numeric_limits<double>::infinity();
+      for (size_t b = 0; b < static_cast<size_t>(Backend::Count); ++b) {
+        if (!IsAvailable(static_cast<Backend>(b))) continue;
+        backend = static_cast<Backend>(b);
+        tier.us[b] = TimeStep();
+        if (tier.us[b] < bestUs) {
+          bestUs = tier.us[b];
+          tier.best = backend;
+        }
+      }
+    }
+
+    flakes = saved;
+    windTimer = savedTime;
+    stepCounter = savedSteps;
+    layerRanges = savedRanges;
+    activeCount = savedActive;
+    landingLog.count = 0;
+    if (motion == Motion::Stateless) {
+      Evaluate();
+    } else {
+      Advance({}, static_cast<float>(accumulator / StepSeconds));
+    }
+    backend = BestBackend();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Snow backend: %s for %zu flakes", GetBackendName(), activeCount);
+    return backend;
+  }
+
+  // Stepped integrates the flakes at Config::snow_sim_hz. Stateless computes every position in closed form from the
+  // time since `origin` and per-flake constants, so no per-flake state is written from frame to frame and any frame
+  // can be evaluated on its own, in any order or split across threads. The two look the same but don't produce
+  // bit-identical positions.
+  enum class Motion { Stepped, Stateless };
+  static constexpr std::array<const char *, 2> MotionNames{"stepped", "stateless"};
+
+  void SetMotion(Motion m) {
+    if (m == motion) return;
+    motion = m;
+    if (motion == Motion::Stateless) {
+      // Fold the current state into path constants so the snow continues from where it is
+      origin = windTimer;
+      paths.Resize(flakes.x.size());
+      for (size_t i = 0; i < flakes.x.size(); ++i) {
+        const double phase = std::fmod(flakes.swayPhase[i] + flakes.swaySpeed[i] * origin, TwoPi);
+        const float amplitude = 10.0f * (1.0f - flakes.depth[i]) / flakes.swaySpeed[i];
+        paths.phase[i] = static_cast<float>(phase);
+        paths.swayAmplitude[i] = amplitude;
+        paths.xBase[i] = flakes.x[i] + amplitude * static_cast<float>(std::cos(phase));
+        paths.yBase[i] = flakes.y[i] + flakes.size[i];
+        paths.invFallPeriod[i] = 1.0f / (screenHeight + flakes.size[i]);
+        paths.invWrapPeriod[i] = 1.0f / (screenWidth + flakes.size[i]);
+        paths.generation[i] = flakes.generation[i];
+        paths.respawnOffset[i] = Random(rng, Stream::RespawnOffset, i, paths.generation[i]);
+      }
+      Evaluate();
+    } else {
+      // Resume stepping from the closed-form positions at the current time
+      std::vector<float> xy(flakes.x.size() * FloatsPerQuad);
+      StatelessKernel<Simd::Scalar>(flakes, paths, xy, nullptr, 0, flakes.x.size(), flakes.x.size(),
+                                    MakeStatelessParams());
+      for (size_t i = 0; i < flakes.x.size(); ++i) {
+        flakes.x[i] = flakes.prevX[i] = xy[i * FloatsPerQuad];
+        flakes.y[i] = flakes.prevY[i] = xy[i * FloatsPerQuad + 1];
+        flakes.swayPhase[i] = static_cast<float>(std::fmod(paths.phase[i] - flakes.swaySpeed[i] * origin, TwoPi));
+        flakes.generation[i] = paths.generation[i] + StatelessRespawns(i, MakeStatelessParams().time);
+      }
+      accumulator = 0.0;
+    }
+  }
+  [[nodiscard]] Motion GetMotion() const { return motion; }
+
+  // A paused system, or one without flakes or lying snow, produces identical frames, so it never damages the screen
+  [[nodiscard]] bool IsAnimating() const { return !paused && (activeCount > 0 || cover.HasSnow()); }
+
+  // Only about `count` flakes are simulated and drawn, the same share of every layer; the rest keep their state for
+  // when quality goes back up. After Calibrate() this also switches to the fastest backend for the new count.
+  void SetActiveCount(size_t count) {
+    SetLayerCounts(count);
+    if (calibration[0].flakes == 0) return;
+    if (const Backend best = BestBackend(); best != backend) {
+      backend = best;
+      SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Snow backend: %s for %zu flakes", GetBackendName(), activeCount);
+    }
+  }
+  [[nodiscard]] size_t GetActiveCount() const { return activeCount; }
+  [[nodiscard]] size_t GetCapacity() const { return flakeCount; }
+  void SetPaused(bool value) { paused = value; }
+  [[nodiscard]] bool IsPaused() const { return paused; }
+
+  // Multiplies the wind; stateless paths are rebased first, so the change applies from now on without a jump
+  void SetWindScale(float scale) {
+    if (scale == windScale) return;
+    if (motion == Motion::Stateless) {
+      RebasePaths(paths, flakes, rng, screenWidth, screenHeight, windScale, origin, windTimer);
+      origin = windTimer;
+    }
+    windScale = scale;
+  }
+
+  [[nodiscard]] static const char *KernelName() { return Simd::Native::Name; }
+
+  // Advances the simulation in fixed steps of 1/Config::snow_sim_hz and renders the state interpolated between the
+  // last two steps, so a slow frame never turns into one big integration step.
+  void Update(double dt) {
+    if (!IsAnimating()) return;
+    if (motion == Motion::Stateless) {
+      windTimer += dt;
+      if (windTimer - origin >= RebaseSeconds) {
+        RebasePaths(paths, flakes, rng, screenWidth, screenHeight, windScale, origin, windTimer);
+        origin = windTimer;
+      }
+      Evaluate();
+      cover.Update(landingLog, static_cast<float>(dt)); // nothing lands, but the snow still melts
+      return;
+    }
+    accumulator += dt;
+    std::array<StepParams, MaxStepsPerUpdate> steps;
+    size_t stepCount = 0;
+    while (accumulator >= StepSeconds && stepCount < MaxStepsPerUpdate) {
+      const auto fDt = static_cast<float>(StepSeconds);
+      windTimer += fDt;
+      steps[stepCount++] = MakeStepParams(windTimer, fDt, &landingLog);
+      accumulator -= StepSeconds;
+    }
+    // After a long stall (e.g. a background upload) drop the backlog instead of fast-forwarding through it
+    if (stepCount == MaxStepsPerUpdate) accumulator = std::min(accumulator, StepSeconds);
+
+    Advance({steps.data(), stepCount}, static_cast<float>(accumulator / StepSeconds));
+    if (stepCount > 0) cover.Update(landingLog, static_cast<float>(stepCount * StepSeconds));
+  }
+
+  // Flakes settle on these and on the bottom of the screen; stateless motion ignores them
+  void SetObstacles(std::span<const SnowCover::Obstacle> obstacles) { cover.SetObstacles(obstacles); }
+  void DrawCover(SDL_Renderer *renderer) { cover.Draw(renderer); }
+
+  // One draw call per layer, far to near: points for the distant layers, sprites of any shape for the others.
+  // `textured` false draws plain quads instead of sprites, which --bench compares against.
+  void Draw(SDL_Renderer *renderer, bool textured = true) {
+    SDL_Texture *texture = textured ? atlas.get() : nullptr;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      const LayerRange &range = layerRanges[l];
+      if (range.active == 0) continue;
+      if (Layers[l].points) {
+        SDL_SetRenderDrawColorFloat(renderer, 1.0f, 1.0f, 1.0f, Layers[l].pointAlpha);
+        SDL_RenderPoints(renderer, &points[range.begin], static_cast<int>(range.active));
+        continue;
+      }
+      SDL_RenderGeometryRaw(renderer, texture, &positions[range.begin * FloatsPerQuad], 2 * sizeof(float),
+                            &colors[range.begin * 4], sizeof(SDL_FColor),
+                            texture ? &uvs[range.begin * FloatsPerQuad] : nullptr, 2 * sizeof(float),
+                            static_cast<int>(range.active * 4), indices.data(), static_cast<int>(range.active * 6),
+                            sizeof(int));
+    }
+  }
+
+  // Vertex data the CPU writes each frame, and the total handed to the renderer per frame
+  [[nodiscard]] size_t GeometryBytesWritten() const {
+    size_t bytes = 0;
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      bytes += layerRanges[l].active * (Layers[l].points ? sizeof(SDL_FPoint) : FloatsPerQuad * sizeof(float));
+    }
+    return bytes;
+  }
+  [[nodiscard]] size_t GeometryBytesSubmitted() const {
+    const size_t uvBytes = atlas ? FloatsPerQuad * sizeof(float) : 0;
+    size_t bytes = GeometryBytesWritten();
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      if (!Layers[l].points) bytes += layerRanges[l].active * (4 * sizeof(SDL_FColor) + uvBytes + 6 * sizeof(int));
+    }
+    return bytes;
+  }
+
+  struct KernelCheck {
+    size_t mismatches = 0;
+    float maxError = 0.0f;
+  };
+
+  // Steps a copy of the current flakes with both the SIMD kernel and the scalar reference, starting every step from
+  // the same state, and compares the results. --bench runs this before measuring anything.
+  [[nodiscard]] KernelCheck VerifyKernel(int steps, float tolerance = 1e-3f) const {
+    KernelCheck check;
+    Flakes reference = flakes;
+    Flakes vectorized;
+    SnowCover::LandingLog referenceLandings, vectorizedLandings;
+    const size_t n = flakes.x.size();
+    referenceLandings.items.resize(n);
+    vectorizedLandings.items.resize(n);
+    double time = windTimer;
+    const auto dt = static_cast<float>(StepSeconds);
+    for (int s = 0; s < steps; ++s) {
+      time += dt;
+      const StepParams params = MakeStepParams(time, dt, &referenceLandings);
+      StepParams vectorizedParams = params;
+      vectorizedParams.landings = &vectorizedLandings;
+      vectorized = reference;
+      referenceLandings.count = 0;
+      vectorizedLandings.count = 0;
+      StepReference(reference, 0, n, params);
+      StepKernel<Simd::Native>(vectorized, 0, n, vectorizedParams);
+      if (referenceLandings.count != vectorizedLandings.count) check.mismatches++;
+      for (size_t i = 0; i < n; ++i) {
+        const float error = std::max({std::abs(reference.x[i] - vectorized.x[i]),
+                                      std::abs(reference.y[i] - vectorized.y[i]),
+                                      std::abs(reference.prevX[i] - vectorized.prevX[i]),
+                                      std::abs(reference.prevY[i] - vectorized.prevY[i])});
+        check.maxError = std::max(check.maxError, error);
+        if (!(error <= tolerance)) check.mismatches++;
+      }
+    }
+    return check;
+  }
+
+  // Evaluates the stateless paths from the current origin and from one moved `seconds` ahead, at times after the
+  // move; the two have to agree or a rebase would be visible
+  [[nodiscard]] KernelCheck VerifyRebase(double seconds, float tolerance = 1e-2f) const {
+    KernelCheck check;
+    const size_t n = flakes.x.size();
+    std::vector<float> before(n * FloatsPerQuad), after(n * FloatsPerQuad);
+    Paths rebased = paths;
+    const double rebaseTime = origin + seconds;
+    RebasePaths(rebased, flakes, rng, screenWidth, screenHeight, windScale, origin, rebaseTime);
+    for (double t = rebaseTime; t <= rebaseTime + 2.0; t += StepSeconds) {
+      StatelessKernel<Simd::Native>(flakes, paths, before, nullptr, 0, n, n, MakeStatelessParams(origin, t));
+      StatelessKernel<Simd::Native>(flakes, rebased, after, nullptr, 0, n, n, MakeStatelessParams(rebaseTime, t));
+      for (size_t i = 0; i < n; ++i) {
+        // A flake sitting exactly on a wrap edge may land on either side of it. At the bottom edge that also changes
+        // the respawn count and so x, but the flake is off-screen in both places.
+        const float dy = std::abs(before[i * FloatsPerQuad + 1] - after[i * FloatsPerQuad + 1]);
+        if (dy > (screenHeight + flakes.size[i]) / 2) continue;
+        // A flake that respawns after the move restarts from the same random x in both, plus the wind since the
+        // respective origin. Either is a valid restart, and only the rebased one is ever drawn.
+        const auto sinceOrigin = static_cast<float>(t - origin);
+        if (StatelessRespawns(i, sinceOrigin) != StatelessRespawns(i, static_cast<float>(seconds))) continue;
+        const float dx = std::abs(before[i * FloatsPerQuad] - after[i * FloatsPerQuad]);
+        const float error = std::max(std::min(dx, std::abs(dx - (screenWidth + flakes.size[i]))), dy);
+        check.maxError = std::max(check.maxError, error);
+        if (!(error <= tolerance)) check.mismatches++;
+      }
+    }
+    return check;
+  }
+
+private:
+  static constexpr double StepSeconds = 1.0 / Config::snow_sim_hz;
+  static constexpr double TwoPi = 2.0 * std::numbers::pi;
+  static constexpr float GoldenRatio = std::numbers::phi_v<float> - 1.0f; // the stateless respawn sequence's stride
+  // Stateless positions are evaluated in float relative to `origin`; moving the origin forward every so often keeps
+  // that time small enough for float precision
+  static constexpr double RebaseSeconds = 600.0;
+  static constexpr int MaxStepsPerUpdate = 4;
+  // Work unit for the parallel backends; big enough to amortise a chunk claim, a multiple of every SIMD width
+  static constexpr size_t ChunkFlakes = 512;
+  static constexpr size_t FloatsPerQuad = 8;
+  static constexpr float DepositPerPixel = 0.04f; // snow depth a landed flake adds, per pixel of its size
+  static_assert(ChunkFlakes % Simd::MaxWidth == 0);
+
+  // Parallax layers, far to near. Distant flakes are small and slow, so they are stepped less often (and
+  // interpolated in between like every other layer) and drawn as single points, which costs a fraction of a sprite.
+  struct Layer {
+    float maxDepth;  // flakes nearer than this belong to a later layer
+    int stepDivider; // stepped once every this many simulation steps, with a step that much longer
+    bool points;     // drawn as points of pointAlpha instead of sprites; they fall behind the labels
+    float pointAlpha;
+  };
+  static constexpr std::array<Layer, 3> Layers{
+      {{0.35f, 3, true, 0.6f}, {0.55f, 2, false, 0.0f}, {1.0f, 1, false, 0.0f}}};
+
+  // Structure of arrays: the step kernel streams through each attribute with full-width vector loads
+  struct Flakes {
+    std::vector<float> x, y;
+    std::vector<float> prevX, prevY; // position one simulation step ago, for interpolation
+    std::vector<float> size;
+    std::vector<float> speedY;
+    std::vector<float> swayPhase;
+    std::vector<float> swaySpeed;
+    std::vector<float> depth;       // 0.0 (far) to 1.0 (near)
+    std::vector<Uint32> generation; // respawns so far; with the slot, it keys the random respawn position
+
+    void Resize(size_t n) {
+      for (auto *v : {&x, &y, &prevX, &prevY, &size, &speedY, &swayPhase, &swaySpeed, &depth}) v->resize(n);
+      generation.resize(n);
+    }
+  };
+
+  // Per-flake constants of the stateless motion, relative to `origin`. Only SetMotion and a rebase write them.
+  struct Paths {
+    std::vector<float> xBase, yBase; // where the flake would be at the origin without wind, sway or wrapping
+    std::vector<float> phase;        // sway phase at the origin
+    std::vector<float> swayAmplitude;
+    std::vector<float> invFallPeriod, invWrapPeriod; // 1 / (height + size), 1 / (width + size)
+    std::vector<float> respawnOffset;                // start of the respawn sequence, in widths
+    std::vector<Uint32> generation;                  // respawns before the origin
+
+    void Resize(size_t n) {
+      for (auto *v : {&xBase, &yBase, &phase, &swayAmplitude, &invFallPeriod, &invWrapPeriod, &respawnOffset}) {
+        v->resize(n);
+      }
+      generation.resize(n);
+    }
+  };
+
+  struct StatelessParams {
+    float time; // since the origin
+    float wind; // horizontal wind displacement since the origin, for a flake at depth 1
+    float width;
+    float height;
+    const CounterRng *rng;
+  };
+
+  struct StepParams {
+    float dt;
+    float time;
+    float wind;
+    float width;
+    float height;
+    const float *ground; // per SnowCover column; flakes crossing it land
+    size_t columns;
+    size_t liveCount; // flakes from here on are simulated but not drawn, so their landings don't count
+    SnowCover::LandingLog *landings;
+    const CounterRng *rng;
+  };
+
+  float screenWidth = 0;
+  float screenHeight = 0;
+  double windTimer = 0.0;
+  double accumulator = 0.0;
+  float windScale = 1.0f;
+  Motion motion = Motion::Stepped;
+  double origin = 0.0; // time the stateless paths are relative to
+  Paths paths;
+  SnowCover cover;
+  SnowCover::LandingLog landingLog;
+  bool paused = false;
+  size_t flakeCount = 0;
+  size_t activeCount = 0; // sum over the layers
+  void SetLayerCounts(size_t count) {
+    activeCount = 0;
+    for (LayerRange &range : layerRanges) {
+      range.active = flakeCount > 0 ? std::min(count, flakeCount) * range.count / flakeCount : 0;
+      activeCount += range.active;
+    }
+  }
+
+  // The calibrated choice of the smallest tier that still has as many flakes as are active
+  [[nodiscard]] Backend BestBackend() const {
+    Backend best = calibration[0].best;
+    for (const CalibrationTier &tier : calibration) {
+      if (tier.flakes > 0 && tier.flakes >= activeCount) best = tier.best;
+    }
+    return best;
+  }
+
+  // Fastest of a few simulation steps with the current backend, in microseconds; moves the snow
+  double TimeStep() {
+    constexpr int warmupRuns = 3;
+    constexpr int timedRuns = 15;
+    Uint64 fastestNs = UINT64_MAX;
+    for (int run = 0; run < warmupRuns + timedRuns; ++run) {
+      const Uint64 start = SDL_GetTicksNS();
+      windTimer += static_cast<float>(StepSeconds);
+      if (motion == Motion::Stateless) {
+        Evaluate();
+      } else {
+        const StepParams params = MakeStepParams(windTimer, static_cast<float>(StepSeconds), &landingLog);
+        Advance({&params, 1}, 0.5f);
+      }
+      if (run >= warmupRuns) fastestNs = std::min(fastestNs, SDL_GetTicksNS() - start);
+    }
+    return static_cast<double>(fastestNs) / 1e3;
+  }
+
+  struct LayerRange {
+    size_t begin;  // first slot, a multiple of Simd::MaxWidth
+    size_t count;  // flakes in the layer; the slots up to the next SIMD boundary are padding
+    size_t active; // of those, the ones simulated and drawn
+  };
+  std::array<LayerRange, Layers.size()> layerRanges{};
+  Uint64 stepCounter = 0; // simulation steps so far, which decides the steps of the slower layers
+  Flakes flakes;
+  std::vector<float> positions;   // x, y of each quad corner, rewritten every frame
+  std::vector<SDL_FPoint> points; // centres of the flakes of point layers, rewritten every frame
+  std::vector<SDL_FColor> colors; // per corner, written when a flake is reset
+  std::vector<float> uvs;         // per corner, written when a flake is reset
+  std::vector<int> indices;
+  TexturePtr atlas;
+  Backend backend = Backend::Simd;
+  std::unique_ptr<WorkerPool> pool;
+  std::array<CalibrationTier, CalibrationTiers> calibration{};
+  CounterRng rng;
+
+  // What each CounterRng stream draws. The key is the flake's slot (for depths, its index before sorting by depth)
+  // and the counter its generation.
+  enum class Stream : Uint32 { Depth, X, Y, Phase, Shape, Respawn, RespawnOffset };
+  static float Random(const CounterRng &rng, Stream stream, size_t flake, Uint32 counter, float lo = 0.0f,
+                      float hi = 1.0f) {
+    return rng.Uniform(static_cast<Uint32>(stream), static_cast<Uint32>(flake), counter, lo, hi);
+  }
+
+  static size_t RoundUpToSimd(size_t n) { return (n + Simd::MaxWidth - 1) / Simd::MaxWidth * Simd::MaxWidth; }
+
+  [[nodiscard]] StepParams MakeStepParams(double time, float dt, SnowCover::LandingLog *landings) const {
+    const float slowWind = 20.0f * std::sin((float)time * 0.5f);
+    const float gustWind = 10.0f * std::sin((float)time * 2.5f);
+    return {dt, (float)time, windScale * (slowWind + gustWind + 5.0f), screenWidth, screenHeight, cover.Ground(),
+            cover.Columns(), flakes.x.size(), landings, &rng};
+  }
+
+  static size_t ColumnOf(const StepParams &p, float x) {
+    const float column = x * (1.0f / SnowCover::ColumnWidth);
+    return column > 0.0f ? std::min(static_cast<size_t>(column), p.columns - 1) : 0;
+  }
+
+  // Integral of the wind speed used by MakeStepParams: 20 sin(t/2) + 10 sin(5t/2) + 5
+  static double WindDisplacement(double t) { return -40.0 * std::cos(0.5 * t) - 4.0 * std::cos(2.5 * t) + 5.0 * t; }
+
+  [[nodiscard]] StatelessParams MakeStatelessParams(double from, double to) const {
+    return {static_cast<float>(to - from),
+            static_cast<float>(windScale * (WindDisplacement(to) - WindDisplacement(from))), screenWidth, screenHeight,
+            &rng};
+  }
+  [[nodiscard]] StatelessParams MakeStatelessParams() const { return MakeStatelessParams(origin, windTimer); }
+
+  // Calls body(layer, begin, end) for the active slots of each layer within [begin, end), padding included
+  template <typename F> void ForEachLayer(size_t begin, size_t end, F &&body) const {
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      const LayerRange &range = layerRanges[l];
+      const size_t from = std::max(begin, range.begin);
+      const size_t to = std::min(end, range.begin + RoundUpToSimd(range.active));
+      if (from < to) body(l, from, to);
+    }
+  }
+  [[nodiscard]] size_t DrawEnd(size_t layer) const { return layerRanges[layer].begin + layerRanges[layer].active; }
+  std::vector<SDL_FPoint> *PointsOf(size_t layer) { return Layers[layer].points ? &points : nullptr; }
+
+  // Every layer is evaluated every frame; only the stepped motion has a cost per step to save
+  void Evaluate() {
+    const StatelessParams params = MakeStatelessParams();
+    if (backend == Backend::Serial) {
+      ForEachLayer(0, flakes.x.size(), [&](size_t l, size_t begin, size_t end) {
+        StatelessKernel<Simd::Scalar>(flakes, paths, positions, PointsOf(l), begin, end, DrawEnd(l), params);
+      });
+      return;
+    }
+    Dispatch(flakes.x.size(), [&](size_t begin, size_t end) {
+      ForEachLayer(begin, end, [&](size_t l, size_t from, size_t to) {
+        StatelessKernel<Simd::Native>(flakes, paths, positions, PointsOf(l), from, to, DrawEnd(l), params);
+      });
+    });
+  }
+
+  // Moves the origin of the paths from `from` to `to` without changing any position: the distance fallen and blown
+  // so far is folded into the bases, reduced by whole wrap periods, the respawns are added to the generation and the
+  // sway phase is advanced.
+  static void RebasePaths(Paths &p, const Flakes &f, const CounterRng &rng, float width, float height, float windScale,
+                          double from, double to) {
+    const double elapsed = to - from;
+    const double wind = windScale * (WindDisplacement(to) - WindDisplacement(from));
+    for (size_t i = 0; i < p.xBase.size(); ++i) {
+      const double fallPeriod = height + f.size[i];
+      const double fall = p.yBase[i] + f.speedY[i] * elapsed;
+      const double respawns = std::max(std::floor(fall / fallPeriod), 0.0);
+      p.yBase[i] = static_cast<float>(fall - respawns * fallPeriod);
+      // The same start StatelessKernel uses, in float like it
+      const float sequence = p.respawnOffset[i] + static_cast<float>(respawns) * GoldenRatio;
+      const double start = respawns > 0.0 ? (sequence - std::floor(sequence)) * width : p.xBase[i];
+      p.xBase[i] = static_cast<float>(std::fmod(start + f.depth[i] * wind, width + f.size[i]));
+      p.generation[i] += static_cast<Uint32>(respawns);
+      p.respawnOffset[i] = Random(rng, Stream::RespawnOffset, i, p.generation[i]);
+      p.phase[i] = static_cast<float>(std::fmod(p.phase[i] + f.swaySpeed[i] * elapsed, TwoPi));
+    }
+  }
+
+  // Respawns since the origin of flake i's path at `time`, as counted by StatelessKernel
+  [[nodiscard]] Uint32 StatelessRespawns(size_t i, float time) const {
+    const float fall = paths.yBase[i] + flakes.speedY[i] * time;
+    return static_cast<Uint32>(std::max(std::floor(fall * paths.invFallPeriod[i]), 0.0f));
+  }
+
+  // Closed form of the stepped motion: fall with wrap-around at the bottom, wind and sway integrated analytically, a
+  // random restart per respawn, and wrap-around at the sides. Writes the flakes before `drawCount`.
+  template <typename Ops>
+  static void StatelessKernel(const Flakes &f, const Paths &p, std::vector<float> &positions,
+                              std::vector<SDL_FPoint> *points, size_t begin, size_t end, size_t drawCount,
+                              const StatelessParams &params) {
+    using V = typename Ops::V;
+    const V time = Ops::Set(params.time);
+    const V wind = Ops::Set(params.wind);
+    const V width = Ops::Set(params.width);
+    const V height = Ops::Set(params.height);
+    const V zero = Ops::Set(0.0f);
+    const V quarterTurn = Ops::Set(std::numbers::pi_v<float> / 2);
+    for (size_t i = begin; i < end; i += Ops::Width) {
+      const V size = Ops::Load(&f.size[i]);
+
+      // Flakes that start above the screen haven't wrapped yet, hence the clamp
+      const V fall = Ops::Add(Ops::Load(&p.yBase[i]), Ops::Mul(Ops::Load(&f.speedY[i]), time));
+      V respawns = Simd::Floor<Ops>(Ops::Mul(fall, Ops::Load(&p.invFallPeriod[i])));
+      respawns = Ops::Select(Ops::Lt(respawns, zero), zero, respawns);
+      const V top = Ops::Sub(Ops::Sub(fall, Ops::Mul(respawns, Ops::Add(height, size))), size);
+
+      // The sway integral is -amplitude * cos(swaySpeed * t + phase), as a sine a quarter turn ahead
+      const V swayArg = Ops::Add(Ops::Mul(Ops::Load(&f.swaySpeed[i]), time), Ops::Load(&p.phase[i]));
+      const V sway = Ops::Mul(Ops::Load(&p.swayAmplitude[i]), Simd::Sin<Ops>(Ops::Add(swayArg, quarterTurn)));
+      // After a respawn the flake starts from a random x instead of xBase: a golden-ratio sequence from a random
+      // offset per flake and origin, which vectorizes where a hash per lane and frame would not. The wind and sway
+      // since the origin still apply; they only offset the start, and keep the path continuous.
+      const V sequence = Ops::Add(Ops::Load(&p.respawnOffset[i]), Ops::Mul(respawns, Ops::Set(GoldenRatio)));
+      const V restart = Ops::Mul(Ops::Sub(sequence, Simd::Floor<Ops>(sequence)), width);
+      const V start = Ops::Select(Ops::Gt(respawns, zero), restart, Ops::Load(&p.xBase[i]));
+      V x = Ops::Add(start, Ops::Mul(Ops::Load(&f.depth[i]), wind));
+      x = Ops::Sub(x, sway);
+      const V shifted = Ops::Add(x, size);
+      const V wrapPeriod = Ops::Add(width, size);
+      const V wraps = Simd::Floor<Ops>(Ops::Mul(shifted, Ops::Load(&p.invWrapPeriod[i])));
+      const V left = Ops::Sub(Ops::Sub(shifted, Ops::Mul(wraps, wrapPeriod)), size);
+      EmitLanes<Ops>(positions, points, i, drawCount, left, top, size);
+    }
+  }
+
+  // Writes the flakes i onwards, up to `drawCount`, as quads or, given `points`, as points at their centres
+  template <typename Ops>
+  static void EmitLanes(std::vector<float> &positions, std::vector<SDL_FPoint> *points, size_t i, size_t drawCount,
+                        typename Ops::V left, typename Ops::V top, typename Ops::V size) {
+    const size_t lanes = std::min(Ops::Width, drawCount > i ? drawCount - i : 0);
+    std::array<float, Simd::MaxWidth> l, t, r, b;
+    if (points) {
+      const typename Ops::V half = Ops::Mul(size, Ops::Set(0.5f));
+      Ops::Store(l.data(), Ops::Add(left, half));
+      Ops::Store(t.data(), Ops::Add(top, half));
+      for (size_t k = 0; k < lanes; ++k) (*points)[i + k] = {l[k], t[k]};
+      return;
+    }
+    Ops::Store(l.data(), left);
+    Ops::Store(t.data(), top);
+    Ops::Store(r.data(), Ops::Add(left, size));
+    Ops::Store(b.data(), Ops::Add(top, size));
+    for (size_t k = 0; k < lanes; ++k) SetQuad(positions, i + k, l[k], t[k], r[k], b[k]);
+  }
+
+  // Runs body(begin, end) over [0, count) with the selected backend. The serial backend is handled by the callers.
+  template <typename F> void Dispatch(size_t count, F &&body) {
+    switch (backend) {
+    case Backend::ThreadPool:
+      pool->ParallelFor(count, ChunkFlakes, body);
+      break;
+#ifdef SNOW_HAVE_TBB
+    case Backend::Tbb:
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, (count + ChunkFlakes - 1) / ChunkFlakes),
+                        [&](const tbb::blocked_range<size_t> &chunks) {
+                          body(chunks.begin() * ChunkFlakes, std::min(chunks.end() * ChunkFlakes, count));
+                        });
+      break;
+#endif
+    default:
+      body(size_t{0}, count);
+      break;
+    }
+  }
+
+  // Runs the given simulation steps and writes the vertex positions interpolated by `alpha`, in a single pass over
+  // the flakes so that each one is loaded once per frame however many steps are due. A layer with a step divider
+  // takes every divider-th step, that many times as long, and is interpolated across the longer step.
+  void Advance(std::span<const StepParams> steps, float alpha) {
+    struct LayerSteps {
+      std::array<StepParams, MaxStepsPerUpdate> items;
+      size_t count = 0;
+      float alpha = 0.0f;
+    };
+    std::array<LayerSteps, Layers.size()> due;
+    for (const StepParams &step : steps) {
+      stepCounter++;
+      for (size_t l = 0; l < Layers.size(); ++l) {
+        if (stepCounter % Layers[l].stepDivider != 0) continue;
+        StepParams &p = due[l].items[due[l].count++] = step;
+        p.dt *= static_cast<float>(Layers[l].stepDivider);
+        p.liveCount = DrawEnd(l);
+        if (Layers[l].points) p.columns = 0;
+      }
+    }
+    for (size_t l = 0; l < Layers.size(); ++l) {
+      const auto divider = static_cast<float>(Layers[l].stepDivider);
+      due[l].alpha = (static_cast<float>(stepCounter % Layers[l].stepDivider) + alpha) / divider;
+    }
+
+    if (backend == Backend::Serial) {
+      ForEachLayer(0, flakes.x.size(), [&](size_t l, size_t begin, size_t end) {
+        for (size_t s = 0; s < due[l].count; ++s) StepReference(flakes, begin, end, due[l].items[s]);
+        WriteVertexPositions(l, due[l].alpha);
+      });
+      return;
+    }
+    Dispatch(flakes.x.size(), [&](size_t begin, size_t end) {
+      ForEachLayer(begin, end, [&](size_t l, size_t from, size_t to) {
+        AdvanceKernel<Simd::Native>(flakes, positions, PointsOf(l), from, to, DrawEnd(l),
+                                    {due[l].items.data(), due[l].count}, due[l].alpha);
+      });
+    });
+  }
+
+  void WriteVertexPositions(size_t layer, float alpha) {
+    for (size_t i = layerRanges[layer].begin; i < DrawEnd(layer); ++i) {
+      const float x = flakes.prevX[i] + (flakes.x[i] - flakes.prevX[i]) * alpha;
+      const float y = flakes.prevY[i] + (flakes.y[i] - flakes.prevY[i]) * alpha;
+      if (Layers[layer].points) {
+        points[i] = {x + flakes.size[i] / 2, y + flakes.size[i] / 2};
+      } else {
+        SetQuad(positions, i, x, y, x + flakes.size[i], y + flakes.size[i]);
+      }
+    }
+  }
+
+  static void SetQuad(std::vector<float> &xy, size_t flake, float left, float top, float right, float bottom) {
+    float *quad = &xy[flake * FloatsPerQuad];
+    quad[0] = left;
+    quad[1] = top;
+    quad[2] = right;
+    quad[3] = top;
+    quad[4] = right;
+    quad[5] = bottom;
+    quad[6] = left;
+    quad[7] = bottom;
+  }
+
+  // Branchless version of StepReference for the Ops::Width flakes starting at i, on values held in registers: every
+  // flake runs the same instructions and wrap-arounds are selects
+  template <typename Ops>
+  static void StepLanes(Flakes &f, size_t i, const StepParams &p, typename Ops::V &x, typename Ops::V &y,
+                        typename Ops::V &prevX, typename Ops::V &prevY) {
+    using V = typename Ops::V;
+    const V dt = Ops::Set(p.dt);
+    const V width = Ops::Set(p.width);
+    const V one = Ops::Set(1.0f);
+    const V size = Ops::Load(&f.size[i]);
+    const V depth = Ops::Load(&f.depth[i]);
+    const V negSize = Ops::Sub(Ops::Set(0.0f), size);
+    const V x0 = x;
+    const V y0 = y;
+
+    y = Ops::Add(y0, Ops::Mul(Ops::Load(&f.speedY[i]), dt));
+    const V swayArg = Ops::Add(Ops::Mul(Ops::Set(p.time), Ops::Load(&f.swaySpeed[i])), Ops::Load(&f.swayPhase[i]));
+    const V sway = Ops::Mul(Simd::Sin<Ops>(swayArg), Ops::Mul(Ops::Set(10.0f), Ops::Sub(one, depth)));
+    x = Ops::Add(x0, Ops::Mul(Ops::Add(Ops::Mul(Ops::Set(p.wind), depth), sway), dt));
+
+    auto respawn = Ops::Gt(y, Ops::Set(p.height));
+    if (p.columns > 0) {
+      // Landed: the flake's bottom crossed the snow surface of the column it started the step in. Gathering the
+      // column heights is scalar; the test is not.
+      std::array<float, Simd::MaxWidth> xs, heights;
+      Ops::Store(xs.data(), x0);
+      for (size_t k = 0; k < Ops::Width; ++k) heights[k] = p.ground[ColumnOf(p, xs[k])];
+      const V ground = Ops::Load(heights.data());
+      const auto landed = Ops::And(Ops::Lt(Ops::Add(y0, size), ground), Ops::Gt(Ops::Add(y, size), ground));
+      if (Ops::Any(landed)) {
+        std::array<float, Simd::MaxWidth> hit, sizes;
+        Ops::Store(hit.data(), Ops::Select(landed, one, Ops::Set(0.0f)));
+        Ops::Store(sizes.data(), size);
+        for (size_t k = 0; k < Ops::Width && i + k < p.liveCount; ++k) {
+          if (hit[k] != 0.0f) p.landings->Record(ColumnOf(p, xs[k]), sizes[k] * DepositPerPixel);
+        }
+      }
+      respawn = Ops::Or(respawn, landed);
+    }
+    y = Ops::Select(respawn, negSize, y);
+    if (Ops::Any(respawn)) {
+      // A handful of flakes per step, so the draws are scalar
+      std::array<float, Simd::MaxWidth> respawned, xs;
+      Ops::Store(respawned.data(), Ops::Select(respawn, one, Ops::Set(0.0f)));
+      Ops::Store(xs.data(), x);
+      for (size_t k = 0; k < Ops::Width; ++k) {
+        if (respawned[k] != 0.0f) xs[k] = RespawnX(f, i + k, p);
+      }
+      x = Ops::Load(xs.data());
+    }
+    const auto over = Ops::Gt(x, width);
+    x = Ops::Select(over, negSize, x);
+    const auto under = Ops::Lt(x, negSize);
+    x = Ops::Select(under, width, x);
+
+    // Don't interpolate across the screen when a flake wraps around
+    const auto wrapped = Ops::Or(respawn, Ops::Or(over, under));
+    prevX = Ops::Select(wrapped, x, x0);
+    prevY = Ops::Select(wrapped, y, y0);
+  }
+
+  template <typename Ops> static void StepKernel(Flakes &f, size_t begin, size_t end, const StepParams &p) {
+    using V = typename Ops::V;
+    for (size_t i = begin; i < end; i += Ops::Width) {
+      V x = Ops::Load(&f.x[i]), y = Ops::Load(&f.y[i]), prevX, prevY;
+      StepLanes<Ops>(f, i, p, x, y, prevX, prevY);
+      Ops::Store(&f.prevX[i], prevX);
+      Ops::Store(&f.prevY[i], prevY);
+      Ops::Store(&f.x[i], x);
+      Ops::Store(&f.y[i], y);
+    }
+  }
+
+  // StepKernel for every due step followed by the interpolated quad or point, without leaving registers in between.
+  // Only the flakes before `drawCount` are written.
+  template <typename Ops>
+  static void AdvanceKernel(Flakes &f, std::vector<float> &positions, std::vector<SDL_FPoint> *points, size_t begin,
+                            size_t end, size_t drawCount, std::span<const StepParams> steps, float alpha) {
+    using V = typename Ops::V;
+    const V a = Ops::Set(alpha);
+    for (size_t i = begin; i < end; i += Ops::Width) {
+      V x = Ops::Load(&f.x[i]), y = Ops::Load(&f.y[i]);
+      V prevX = Ops::Load(&f.prevX[i]), prevY = Ops::Load(&f.prevY[i]);
+      if (!steps.empty()) {
+        for (const StepParams &p : steps) StepLanes<Ops>(f, i, p, x, y, prevX, prevY);
+        Ops::Store(&f.prevX[i], prevX);
+        Ops::Store(&f.prevY[i], prevY);
+        Ops::Store(&f.x[i], x);
+        Ops::Store(&f.y[i], y);
+      }
+
+      const V size = Ops::Load(&f.size[i]);
+      const V left = Ops::Add(prevX, Ops::Mul(Ops::Sub(x, prevX), a));
+      const V top = Ops::Add(prevY, Ops::Mul(Ops::Sub(y, prevY), a));
+      EmitLanes<Ops>(positions, points, i, drawCount, left, top, size);
+    }
+  }
+
+  // A respawned flake starts its next generation at a random x, the same whichever thread or kernel draws it
+  static float RespawnX(Flakes &f, size_t i, const StepParams &p) {
+    return Random(*p.rng, Stream::Respawn, i, ++f.generation[i], 0.0f, p.width);
+  }
+
+  // The straightforward per-flake version the kernels are checked against
+  static void StepReference(Flakes &f, size_t begin, size_t end, const StepParams &p) {
+    for (size_t i = begin; i < end; ++i) {
+      f.prevX[i] = f.x[i];
+      f.prevY[i] = f.y[i];
+      f.y[i] += f.speedY[i] * p.dt;
+      float individualSway = std::sin(p.time * f.swaySpeed[i] + f.swayPhase[i]) * (10.0f * (1.0f - f.depth[i]));
+      const float x0 = f.x[i];
+      f.x[i] += (p.wind * f.depth[i] + individualSway) * p.dt;
+      bool landed = false;
+      if (p.columns > 0) {
+        const size_t column = ColumnOf(p, x0);
+        landed = f.prevY[i] + f.size[i] < p.ground[column] && f.y[i] + f.size[i] > p.ground[column];
+        if (landed && i < p.liveCount) p.landings->Record(column, f.size[i] * DepositPerPixel);
+      }
+      bool wrapped = false;
+      if (f.y[i] > p.height || landed) {
+        f.y[i] = -f.size[i];
+        f.x[i] = RespawnX(f, i, p);
+        wrapped = true;
+      }
+      if (f.x[i] > p.width) {
+        f.x[i] = -f.size[i];
+        wrapped = true;
+      } else if (f.x[i] < -f.size[i]) {
+        f.x[i] = p.width;
+        wrapped = true;
+      }
+      if (wrapped) {
+        f.prevX[i] = f.x[i];
+        f.prevY[i] = f.y[i];
+      }
+    }
+  }
+
+  // The atlas holds a round and a six-armed crystal flake, each drawn at several sizes so that small flakes are
+  // sampled from a small sprite instead of a blurry downscale. Shapes are rows, sizes are columns, largest first.
+  enum class Shape { Round, Crystal, Count };
+  static constexpr std::array<int, 3> SpriteSizes{32, 16, 8};
+  static constexpr int AtlasWidth = 32 + 16 + 8;
+  static constexpr int AtlasHeight = 32 * static_cast<int>(Shape::Count);
+
+  static SDL_FRect SpriteRect(Shape shape, size_t sizeIndex) {
+    int x = 0;
+    for (size_t k = 0; k < sizeIndex; ++k) x += SpriteSizes[k];
+    return {static_cast<float>(x), static_cast<float>(static_cast<int>(shape) * SpriteSizes[0]),
+            static_cast<float>(SpriteSizes[sizeIndex]), static_cast<float>(SpriteSizes[sizeIndex])};
+  }
+
+  // Coverage of a shape at (x, y), in units of the sprite radius with the centre at the origin
+  static float ShapeCoverage(Shape shape, float x, float y) {
+    const float r = std::hypot(x, y);
+    if (shape == Shape::Round) {
+      // Soft-edged disc, a little brighter in the middle
+      const float edge = std::clamp((0.95f - r) / 0.45f, 0.0f, 1.0f);
+      return edge * edge * (3.0f - 2.0f * edge);
+    }
+    // Distance from the point to the segment a-b, both given as direction and length from the arm base
+    auto segmentDistance = [x, y](float ax, float ay, float bx, float by) {
+      const float dx = bx - ax, dy = by - ay;
+      const float t = std::clamp(((x - ax) * dx + (y - ay) * dy) / (dx * dx + dy * dy), 0.0f, 1.0f);
+      return std::hypot(x - (ax + t * dx), y - (ay + t * dy));
+    };
+    float distance = r - 0.12f; // small hub
+    for (int arm = 0; arm < 6; ++arm) {
+      const float angle = static_cast<float>(arm) * std::numbers::pi_v<float> / 3.0f;
+      const float cx = std::cos(angle), cy = std::sin(angle);
+      distance = std::min(distance, segmentDistance(0.0f, 0.0f, 0.9f * cx, 0.9f * cy));
+      // A pair of side branches halfway along each arm
+      const float bx = 0.5f * cx, by = 0.5f * cy;
+      for (const float side : {-1.0f, 1.0f}) {
+        const float branch = angle + side * std::numbers::pi_v<float> / 3.0f;
+        distance = std::min(distance, segmentDistance(bx, by, bx + 0.3f * std::cos(branch),
+                                                      by + 0.3f * std::sin(branch)));
+      }
+    }
+    return distance < 0.08f ? 1.0f : 0.0f;
+  }
+
+  // White sprites with coverage in alpha, so the vertex colour sets each flake's brightness
+  static SurfacePtr MakeSpriteAtlas() {
+    SurfacePtr surface(SDL_CreateSurface(AtlasWidth, AtlasHeight, SDL_PIXELFORMAT_RGBA32));
+    if (!surface) return nullptr;
+    SDL_ClearSurface(surface.get(), 1.0f, 1.0f, 1.0f, 0.0f);
+    constexpr int samples = 4; // per axis, for anti-aliasing
+    auto *pixels = static_cast<Uint8 *>(surface->pixels);
+    for (size_t shape = 0; shape < static_cast<size_t>(Shape::Count); ++shape) {
+      for (size_t sizeIndex = 0; sizeIndex < SpriteSizes.size(); ++sizeIndex) {
+        const SDL_FRect cell = SpriteRect(static_cast<Shape>(shape), sizeIndex);
+        const int size = SpriteSizes[sizeIndex];
+        // One texel of margin keeps linear filtering from bleeding into the neighbouring cell
+        const float radius = static_cast<float>(size) / 2.0f - 1.0f;
+        for (int py = 0; py < size; ++py) {
+          for (int px = 0; px < size; ++px) {
+            float coverage = 0.0f;
+            for (int sy = 0; sy < samples; ++sy) {
+              for (int sx = 0; sx < samples; ++sx) {
+                const float x = (static_cast<float>(px) + (sx + 0.5f) / samples) - size / 2.0f;
+                const float y = (static_cast<float>(py) + (sy + 0.5f) / samples) - size / 2.0f;
+                coverage += ShapeCoverage(static_cast<Shape>(shape), x / radius, y / radius);
+              }
+            }
+            const int row = static_cast<int>(cell.y) + py;
+            const int column = static_cast<int>(cell.x) + px;
+            pixels[row * surface->pitch + column * 4 + 3] =
+                static_cast<Uint8>(std::lround(255.0f * coverage / (samples * samples)));
+          }
+        }
+      }
+    }
+    return surface;
+  }
+
+  void ResetFlake(size_t i, float depth) {
+    flakes.depth[i] = depth;
+    flakes.size[i] = 3.0f + (depth * 5.0f); // sprites have soft edges, so slightly larger than the old squares
+    flakes.speedY[i] = 30.0f + (depth * 60.0f);
+    flakes.swayPhase[i] = Random(rng, Stream::Phase, i, 0, 0.0f, 2.0f * std::numbers::pi_v<float>);
+    flakes.swaySpeed[i] = 1.0f + (depth * 2.0f);
+    flakes.x[i] = Random(rng, Stream::X, i, 0, 0.0f, screenWidth);
+    flakes.y[i] = Random(rng, Stream::Y, i, 0, -50.0f, screenHeight);
+    flakes.generation[i] = 0;
+    flakes.prevX[i] = flakes.x[i];
+    flakes.prevY[i] = flakes.y[i];
+    const SDL_FColor color = {1.0f, 1.0f, 1.0f, 0.2f + (depth * 0.8f)};
+    std::fill_n(&colors[i * 4], 4, color);
+
+    // Crystals only on the nearer flakes, where their arms are big enough to make out. The sprite is the smallest
+    // one at least twice the flake's size.
+    const Shape shape = depth > 0.6f && Random(rng, Stream::Shape, i, 0) < 0.4f ? Shape::Crystal : Shape::Round;
+    size_t sizeIndex = SpriteSizes.size() - 1;
+    while (sizeIndex > 0 && SpriteSizes[sizeIndex] < 2.0f * flakes.size[i]) sizeIndex--;
+    const SDL_FRect cell = SpriteRect(shape, sizeIndex);
+    const float u0 = cell.x / AtlasWidth, u1 = (cell.x + cell.w) / AtlasWidth;
+    const float v0 = cell.y / AtlasHeight, v1 = (cell.y + cell.h) / AtlasHeight;
+    const std::array<float, FloatsPerQuad> quad{u0, v0, u1, v0, u1, v1, u0, v1};
+    std::ranges::copy(quad, &uvs[i * FloatsPerQuad]);
+  }
+};
+
+// Particles at constant velocity for the weather other than snow, which has SnowSystem. The engine owns the state,
+// respawning and the draw call; a policy says how its particles look and move, as constants and an inline Shape, so
+// every policy is compiled into a vector loop of its own. Constant velocity integrates exactly, so particles move by
+// the frame time once per frame and need no fixed step.
+template <typename Policy> class ParticleSystem {
+public:
+  void Init(float width, float height, size_t count, Uint64 seed) {
+    screenWidth = width;
+    screenHeight = height;
+    capacity = count;
+    activeCount = 0;
+    rng = CounterRng(seed);
+    const size_t slots = (count + Simd::MaxWidth - 1) / Simd::MaxWidth * Simd::MaxWidth;
+    for (auto *v : {&x, &y, &speed, &invSpeed, &size}) v->resize(slots);
+    generation.assign(slots, 0);
+    positions.resize(count * Policy::Corners * 2);
+    colors.resize(count * Policy::Corners);
+    indices.resize(count * Policy::Indices.size());
+    for (size_t i = 0; i < count; ++i) {
+      for (size_t k = 0; k < Policy::Indices.size(); ++k) {
+        indices[i * Policy::Indices.size() + k] = static_cast<int>(i * Policy::Corners) + Policy::Indices[k];
+      }
+    }
+    for (size_t i = 0; i < slots; ++i) Spawn(i);
+  }
+
+  void SetActiveCount(size_t count) { activeCount = std::min(count, capacity); }
+  [[nodiscard]] size_t GetActiveCount() const { return activeCount; }
+  [[nodiscard]] size_t GetCapacity() const { return capacity; }
+  // Horizontal wind in px/s, which the policy scales by how easily its particles are blown about
+  void SetWind(float pixelsPerSecond) { wind = pixelsPerSecond * Policy::WindResponse; }
+  [[nodiscard]] bool IsAnimating() const { return activeCount > 0; }
+
+  void Update(float dt) {
+    if (activeCount > 0) Step<Simd::Native>(dt);
+  }
+
+  void Draw(SDL_Renderer *renderer) const {
+    if (activeCount == 0) return;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometryRaw(renderer, nullptr, positions.data(), 2 * sizeof(float), colors.data(), sizeof(SDL_FColor),
+                          nullptr, 0, static_cast<int>(activeCount * Policy::Corners), indices.data(),
+                          static_cast<int>(activeCount * Policy::Indices.size()), sizeof(int));
+  }
+
+  struct Check {
+    double microsecondsPerUpdate = 0.0; // native loop, all particles active
+    float maxDeviation = 0.0f;          // of the native loop's corners from the scalar loop's
+  };
+
+  // Runs copies with every particle active through `updates` frames, with the native loop and the scalar one, and
+  // compares where they end up. --bench prints this for each policy.
+  [[nodiscard]] Check Measure(int updates, float dt) const {
+    Check check;
+    ParticleSystem native = *this, scalar = *this;
+    native.activeCount = scalar.activeCount = capacity;
+    const Uint64 start = SDL_GetTicksNS();
+    for (int u = 0; u < updates; ++u) native.template Step<Simd::Native>(dt);
+    check.microsecondsPerUpdate = static_cast<double>(SDL_GetTicksNS() - start) / 1e3 / std::max(updates, 1);
+    for (int u = 0; u < updates; ++u) scalar.template Step<Simd::Scalar>(dt);
+    for (size_t i = 0; i < positions.size(); ++i) {
+      check.maxDeviation = std::max(check.maxDeviation, std::abs(native.positions[i] - scalar.positions[i]));
+    }
+    return check;
+  }
+
+private:
+  enum class Stream : Uint32 { Speed, Size, Alpha, X, Y, Respawn };
+
+  // Moves the active particles, wraps them around the screen and writes their corners
+  template <typename Ops> void Step(float dt) {
+    using V = typename Ops::V;
+    constexpr size_t Corners = Policy::Corners;
+    const V zero = Ops::Set(0.0f);
+    const V one = Ops::Set(1.0f);
+    const V two = Ops::Set(2.0f);
+    const V time = Ops::Set(dt);
+    const V drift = Ops::Set(wind * dt);
+    const V windSpeed = Ops::Set(wind);
+    const V width = Ops::Set(screenWidth);
+    const V height = Ops::Set(screenHeight);
+    for (size_t i = 0; i < activeCount; i += Ops::Width) {
+      const V s = Ops::Load(&size[i]);
+      V px = Ops::Add(Ops::Load(&x[i]), drift);
+      V py = Ops::Add(Ops::Load(&y[i]), Ops::Mul(Ops::Load(&speed[i]), time));
+
+      // Past the bottom: back above the top by the screen height plus the particle's extent, at a random x
+      const auto below = Ops::Gt(Ops::Sub(py, s), height);
+      py = Ops::Select(below, Ops::Sub(py, Ops::Add(height, Ops::Mul(s, two))), py);
+      if (Ops::Any(below)) {
+        std::array<float, Simd::MaxWidth> respawned, xs;
+        Ops::Store(respawned.data(), Ops::Select(below, one, zero));
+        Ops::Store(xs.data(), px);
+        for (size_t k = 0; k < Ops::Width; ++k) {
+          if (respawned[k] != 0.0f) xs[k] = Random(Stream::Respawn, i + k, ++generation[i + k], 0.0f, screenWidth);
+        }
+        px = Ops::Load(xs.data());
+      }
+      // Past a side: around to the other one
+      const V span = Ops::Add(width, Ops::Mul(s, two));
+      px = Ops::Select(Ops::Gt(Ops::Sub(px, s), width), Ops::Sub(px, span), px);
+      px = Ops::Select(Ops::Lt(Ops::Add(px, s), zero), Ops::Add(px, span), px);
+      Ops::Store(&x[i], px);
+      Ops::Store(&y[i], py);
+
+      V cornerX[Corners], cornerY[Corners];
+      Policy::template Shape<Ops>(px, py, s, Ops::Mul(windSpeed, Ops::Load(&invSpeed[i])), cornerX, cornerY);
+      std::array<std::array<float, Simd::MaxWidth>, Corners> xs, ys;
+      for (size_t v = 0; v < Corners; ++v) {
+        Ops::Store(xs[v].data(), cornerX[v]);
+        Ops::Store(ys[v].data(), cornerY[v]);
+      }
+      const size_t lanes = std::min(Ops::Width, activeCount - i);
+      for (size_t k = 0; k < lanes; ++k) {
+        float *corners = &positions[(i + k) * Corners * 2];
+        for (size_t v = 0; v < Corners; ++v) {
+          corners[v * 2] = xs[v][k];
+          corners[v * 2 + 1] = ys[v][k];
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] float Random(Stream stream, size_t i, Uint32 counter, float lo, float hi) const {
+    return rng.Uniform(static_cast<Uint32>(stream), static_cast<Uint32>(i), counter, lo, hi);
+  }
+
+  void Spawn(size_t i) {
+    speed[i] = Random(Stream::Speed, i, 0, Policy::MinSpeed, Policy::MaxSpeed);
+    invSpeed[i] = speed[i] > 0.0f ? 1.0f / speed[i] : 0.0f;
+    size[i] = Random(Stream::Size, i, 0, Policy::MinSize, Policy::MaxSize);
+    x[i] = Random(Stream::X, i, 0, 0.0f, screenWidth);
+    y[i] = Random(Stream::Y, i, 0, -size[i], screenHeight + size[i]);
+    if (i < capacity) {
+      const float alpha = Random(Stream::Alpha, i, 0, Policy::MinAlpha, Policy::MaxAlpha);
+      for (size_t v = 0; v < Policy::Corners; ++v) {
+        const SDL_FColor &c = Policy::Color;
+        colors[i * Policy::Corners + v] = {c.r, c.g, c.b, alpha * Policy::CornerAlpha[v]};
+      }
+    }
+  }
+
+  float screenWidth = 0.0f;
+  float screenHeight = 0.0f;
+  float wind = 0.0f; // px/s
+  size_t capacity = 0;
+  size_t activeCount = 0;
+  CounterRng rng;
+  // Structure of arrays, padded to Simd::MaxWidth
+  std::vector<float> x, y;            // the point Policy::Shape builds the particle around
+  std::vector<float> speed, invSpeed; // downwards, px/s
+  std::vector<float> size;
+  std::vector<Uint32> generation; // respawns so far, which key the random x
+  std::vector<float> positions;   // x, y of each corner, rewritten every frame
+  std::vector<SDL_FColor> colors; // per corner, written at spawn
+  std::vector<int> indices;
+};
+
+// Rain: thin streaks along the direction of fall, bright at the head and fading out towards the tail
+struct RainPolicy {
+  static constexpr float MinSpeed = 650.0f, MaxSpeed = 900.0f; // px/s
+  static constexpr float MinSize = 18.0f, MaxSize = 34.0f;     // streak length
+  static constexpr float MinAlpha = 0.25f, MaxAlpha = 0.5f;
+  static constexpr float WindResponse = 1.0f;
+  static constexpr float StreakWidth = 1.2f;
+  static constexpr SDL_FColor Color{0.75f, 0.82f, 0.95f, 1.0f};
+  static constexpr size_t Corners = 4;
+  static constexpr std::array<float, Corners> CornerAlpha{1.0f, 1.0f, 0.0f, 0.0f};
+  static constexpr std::array<int, 6> Indices{0, 1, 2, 2, 3, 0};
+
+  // Head at (x, y), the tail `size` higher and back along the velocity, whose slope is `slant` (dx / dy)
+  template <typename Ops>
+  static void Shape(typename Ops::V x, typename Ops::V y, typename Ops::V size, typename Ops::V slant,
+                    typename Ops::V *cornerX, typename Ops::V *cornerY) {
+    const typename Ops::V width = Ops::Set(StreakWidth);
+    const typename Ops::V tailX = Ops::Sub(x, Ops::Mul(slant, size));
+    const typename Ops::V tailY = Ops::Sub(y, size);
+    cornerX[0] = x;
+    cornerX[1] = Ops::Add(x, width);
+    cornerX[2] = Ops::Add(tailX, width);
+    cornerX[3] = tailX;
+    cornerY[0] = cornerY[1] = y;
+    cornerY[2] = cornerY[3] = tailY;
+  }
+};
+
+// Drizzle: the same streaks, shorter, slower and blown about more
+struct DrizzlePolicy : RainPolicy {
+  static constexpr float MinSpeed = 250.0f, MaxSpeed = 380.0f;
+  static constexpr float MinSize = 6.0f, MaxSize = 12.0f;
+  static constexpr float MinAlpha = 0.2f, MaxAlpha = 0.4f;
+  static constexpr float WindResponse = 1.6f;
+};
+
+// Fog: large soft patches drifting with the wind. Each is a 3x3 grid of corners with all the alpha on the middle one,
+// so it fades out towards every edge without a texture.
+struct FogPolicy {
+  static constexpr float MinSpeed = 0.0f, MaxSpeed = 3.0f;
+  static constexpr float MinSize = 140.0f, MaxSize = 260.0f; // half the width
+  static constexpr float MinAlpha = 0.1f, MaxAlpha = 0.22f;
+  static constexpr float WindResponse = 0.4f;
+  static constexpr float Aspect = 0.4f; // height / width
+  static constexpr SDL_FColor Color{0.85f, 0.87f, 0.9f, 1.0f};
+  static constexpr size_t Corners = 9;
+  static constexpr std::array<float, Corners> CornerAlpha{0, 0, 0, 0, 1, 0, 0, 0, 0};
+  static constexpr std::array<int, 24> Indices{0, 1, 4, 4, 3, 0, 1, 2, 5, 5, 4, 1,
+                                               3, 4, 7, 7, 6, 3, 4, 5, 8, 8, 7, 4};
+
+  // Centred on (x, y); corners row by row
+  template <typename Ops>
+  static void Shape(typename Ops::V x, typename Ops::V y, typename Ops::V size, typename Ops::V,
+                    typename Ops::V *cornerX, typename Ops::V *cornerY) {
+    const typename Ops::V halfHeight = Ops::Mul(size, Ops::Set(Aspect));
+    const typename Ops::V columns[3] = {Ops::Sub(x, size), x, Ops::Add(x, size)};
+    const typename Ops::V rows[3] = {Ops::Sub(y, halfHeight), y, Ops::Add(y, halfHeight)};
+    for (size_t v = 0; v < Corners; ++v) {
+      cornerX[v] = columns[v % 3];
+      cornerY[v] = rows[v / 3];
+    }
+  }
+};
+
+// Rain, drizzle and fog, of which the weather selects at most one. A system without particles costs nothing, so with
+// snow or a clear sky these are idle.
+class WeatherEffects {
+public:
+  void Init(float width, float height, Uint64 seed) {
+    rain.Init(width, height, Config::num_raindrops, seed + 1);
+    drizzle.Init(width, height, Config::num_drizzle_drops, seed + 2);
+    fog.Init(width, height, Config::num_fog_patches, seed + 3);
+  }
+
+  // Activates `share` of the particles of the system for `kind` and none of the others
+  void Set(WeatherScene::Kind kind, float share, double windspeed) {
+    auto portion = [&](const auto &system, WeatherScene::Kind k) -> size_t {
+      return k == kind ? static_cast<size_t>(std::lround(share * static_cast<float>(system.GetCapacity()))) : 0;
+    };
+    rain.SetActiveCount(portion(rain, WeatherScene::Kind::Rain));
+    drizzle.SetActiveCount(portion(drizzle, WeatherScene::Kind::Drizzle));
+    fog.SetActiveCount(portion(fog, WeatherScene::Kind::Fog));
+    const auto wind = static_cast<float>(windspeed) * WindPixelsPerMs;
+    rain.SetWind(wind);
+    drizzle.SetWind(wind);
+    fog.SetWind(wind);
+  }
+
+  [[nodiscard]] bool IsAnimating() const {
+    return !paused && (rain.IsAnimating() || drizzle.IsAnimating() || fog.IsAnimating());
+  }
+  void SetPaused(bool value) { paused = value; }
+  [[nodiscard]] size_t GetActiveCount() const {
+    return rain.GetActiveCount() + drizzle.GetActiveCount() + fog.GetActiveCount();
+  }
+
+  void Update(double dt) {
+    if (!IsAnimating()) return;
+    const auto fDt = static_cast<float>(dt);
+    rain.Update(fDt);
+    drizzle.Update(fDt);
+    fog.Update(fDt);
+  }
+
+  void Draw(SDL_Renderer *renderer) const {
+    fog.Draw(renderer);
+    drizzle.Draw(renderer);
+    rain.Draw(renderer);
+  }
+
+  // Prints each system's update cost at full capacity and how far its native loop strays from the scalar one; false
+  // if any strays more than `tolerance` px
+  [[nodiscard]] bool PrintMeasurements(int updates, float dt, float tolerance = 1e-3f) const {
+    bool agree = true;
+    auto print = [&](const char *name, const auto &system) {
+      const auto check = system.Measure(updates, dt);
+      std::printf("%s %zu x %.2f us (max deviation from scalar %.2g)", name, system.GetCapacity(),
+                  check.microsecondsPerUpdate, check.maxDeviation);
+      if (!(check.maxDeviation <= tolerance)) agree = false;
+    };
+    std::printf("weather particles per update: ");
+    print("rain", rain);
+    print(", drizzle", drizzle);
+    print(", fog", fog);
+    std::printf("\n");
+    return agree;
+  }
+
+private:
+  static constexpr float WindPixelsPerMs = 12.0f; // horizontal px/s per m/s of wind
+
+  ParticleSystem<RainPolicy> rain;
+  ParticleSystem<DrizzlePolicy> drizzle;
+  ParticleSystem<FogPolicy> fog;
+  bool paused = false;
+};
+
+// Per pixel column of `surface`, the first row that is mostly opaque (infinity if none); snow settles on it
+void MeasureColumnTops(SDL_Surface *surface, std::vector<float> &columnTops) {
+  columnTops.assign(surface->w, std::numeric_limits<float>::infinity());
+  SurfacePtr converted;
+  if (surface->format != SDL_PIXELFORMAT_ARGB8888) {
+    converted.reset(SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888));
+    if (!converted) return;
+    surface = converted.get();
+  }
+  if (!SDL_LockSurface(surface)) return;
+  size_t remaining = columnTops.size();
+  const auto *pixels = static_cast<const Uint8 *>(surface->pixels);
+  for (int y = 0; y < surface->h && remaining > 0; ++y) {
+    const auto *row = reinterpret_cast<const Uint32 *>(pixels + y * surface->pitch);
+    for (int x = 0; x < surface->w; ++x) {
+      if ((row[x] >> 24) >= 128 && std::isinf(columnTops[x])) {
+        columnTops[x] = static_cast<float>(y);
+        remaining--;
+      }
+    }
+  }
+  SDL_UnlockSurface(surface);
+}
+
+// Column tops of every glyph of a font, each measured once on its rasterized image. A label adds them up at the
+// glyph positions of its layout, so the snow settles on the pixels that are drawn and not on the glyph boxes.
+class GlyphColumnTops {
+public:
+  struct Glyph {
+    int left = 0; // from the pen position to the first column of the image
+    int top = 0;  // from the top of the line to the first row of the image
+    std::vector<float> columnTops;
+  };
+
+  // Everything the date, weather and advice texts are made of is measured up front, so new texts don't rasterize
+  void Init(TTF_Font *newFont) {
+    font = newFont;
+    glyphs.clear();
+    for (Uint32 ch = 0x20; ch < 0x7F; ++ch) Add(ch);
+    for (Uint32 ch = 0x400; ch < 0x460; ++ch) Add(ch); // Cyrillic
+    Add(0xB0);                                          // degree sign
+  }
+
+  [[nodiscard]] TTF_Font *Font() const { return font; }
+
+  const Glyph &Find(Uint32 ch) {
+    const auto it = glyphs.find(ch);
+    return it != glyphs.end() ? it->second : Add(ch);
+  }
+
+private:
+  // A glyph the font lacks, or one without pixels, keeps an empty entry so it isn't looked up again
+  const Glyph &Add(Uint32 ch) {
+    Glyph &glyph = glyphs[ch];
+    int minX, maxX, minY, maxY, advance;
+    if (!TTF_GetGlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &advance)) return glyph;
+    SurfacePtr image(TTF_GetGlyphImage(font, ch, nullptr));
+    if (!image) return glyph;
+    glyph.left = minX;
+    glyph.top = TTF_GetFontAscent(font) - maxY;
+    MeasureColumnTops(image.get(), glyph.columnTops);
+    return glyph;
+  }
+
+  TTF_Font *font = nullptr;
+  std::unordered_map<Uint32, Glyph> glyphs;
+};
+
+// The big clock only ever shows "0123456789:". Each of those glyphs is rasterized once at startup into one sheet,
+// together with its advance, its kerning against the others and its column tops, so that a time string is a row of
+// quads out of the atlas textures: a minute flip rewrites a few vertices instead of rendering a 382 px string and
+// uploading it as a new texture.
+//
+// The sheet is kept as a signed distance field, which the textures are resolved from for the current output size (the
+// renderer has no custom shaders to do that per pixel). A resize resolves it again instead of stretching 382 px
+// bitmaps, and the optional outline comes out of the same field.
+class DigitAtlas {
+public:
+  static constexpr std::string_view Glyphs = "0123456789:";
+
+  // Vertices of a run of glyphs, drawn with one geometry call per stretch of glyphs on the same page
+  struct Quads {
+    struct Run {
+      size_t page;
+      int first; // into indices
+      int count;
+    };
+
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<SDL_FColor> colors;
+    std::vector<int> indices;
+    std::vector<Run> runs; // in the order the glyphs were emitted, so shadows stay under the text
+
+    void Clear() {
+      positions.clear();
+      uvs.clear();
+      colors.clear();
+      indices.clear();
+      runs.clear();
+    }
+
+    void Reserve(size_t glyphs) {
+      positions.reserve(glyphs * 8);
+      uvs.reserve(glyphs * 8);
+      colors.reserve(glyphs * 4);
+      indices.reserve(glyphs * 6);
+      runs.reserve(glyphs);
+    }
+  };
+
+  // Where a glyph's cell landed in the textures resolved for a scale
+  struct Placement {
+    size_t page = 0;
+    float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+  };
+
+  // The pages resolved for a scale, and the placement of every glyph on them
+  struct Resolved {
+    float scale = 0.0f;
+    std::vector<SurfacePtr> pages;
+    std::array<Placement, Glyphs.size()> placements{};
+  };
+
+  bool Init(SDL_Renderer *renderer, TTF_Font *font) {
+    pages.clear();
+    resolvedScale = 0.0f;
+    // A one-character string is rendered at the font's line height with the baseline on the same row as in a longer
+    // string, so the cells line up without per-glyph offsets
+    const SDL_Color white = {255, 255, 255, SDL_ALPHA_OPAQUE};
+    maxTextureSize = static_cast<int>(SDL_GetNumberProperty(
+        SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, DefaultMaxTextureSize));
+    std::array<SurfacePtr, Glyphs.size()> cells;
+    double area = 0.0;
+    for (size_t g = 0; g < Glyphs.size(); ++g) {
+      int minX, maxX, minY, maxY;
+      cells[g].reset(TTF_RenderText_Blended(font, &Glyphs[g], 1, white));
+      if (cells[g] && cells[g]->format != SDL_PIXELFORMAT_ARGB8888) {
+        cells[g].reset(SDL_ConvertSurface(cells[g].get(), SDL_PIXELFORMAT_ARGB8888));
+      }
+      if (!cells[g] || !TTF_GetGlyphMetrics(font, Glyphs[g], &minX, &maxX, &minY, &maxY, &glyphs[g].advance)) {
+        return false;
+      }
+      MeasureColumnTops(cells[g].get(), glyphs[g].columnTops);
+      area += static_cast<double>(cells[g]->w + 2 * Spread) * (cells[g]->h + 2 * Spread);
+    }
+    // Cells are packed in rows, each with a margin as wide as the distance field reaches. The rows wrap to keep the
+    // sheet about square; it never becomes a texture, only the cells resolved from it do.
+    const int wrap = static_cast<int>(std::ceil(std::sqrt(area)));
+    int x = 0, y = 0, rowHeight = 0;
+    sheetWidth = sheetHeight = 0;
+    largestCell = 0;
+    for (size_t g = 0; g < Glyphs.size(); ++g) {
+      const int w = cells[g]->w + 2 * Spread, h = cells[g]->h + 2 * Spread;
+      largestCell = std::max({largestCell, w, h});
+      if (x > 0 && x + w > wrap) {
+        x = 0;
+        y += rowHeight;
+        rowHeight = 0;
+      }
+      glyphs[g].cell = {x + Spread, y + Spread, cells[g]->w, cells[g]->h};
+      x += w;
+      rowHeight = std::max(rowHeight, h);
+      sheetWidth = std::max(sheetWidth, x);
+      sheetHeight = std::max(sheetHeight, y + rowHeight);
+    }
+    for (size_t a = 0; a < Glyphs.size(); ++a) {
+      for (size_t b = 0; b < Glyphs.size(); ++b) {
+        if (!TTF_GetGlyphKerning(font, Glyphs[a], Glyphs[b], &kerning[a][b])) kerning[a][b] = 0;
+      }
+    }
+    height = cells[0]->h;
+
+    // Zero is as far outside as the field reaches, so the margins need no writing
+    field.assign(static_cast<size_t>(sheetWidth) * sheetHeight, 0);
+    for (size_t g = 0; g < Glyphs.size(); ++g) {
+      if (!StoreDistances(cells[g].get(), glyphs[g].cell)) return false;
+    }
+    return SetScale(renderer, 1.0f);
+  }
+
+  // The textures the digits are drawn from are resolved from the distance field with `scale` texels per logical
+  // pixel, so that they stay sharp on a display larger than the logical size. Each glyph cell is resolved on its own
+  // and the cells are spread over as many textures as the renderer's size limit needs, so only the largest cell has
+  // to fit in one: with the Pi's 2048 px that allows about 4x. The scale is rounded up to eighths so that resizes
+  // rarely resolve again, and clamped to that limit; a larger output upscales the clamped digits, which are then no
+  // longer crisp.
+  [[nodiscard]] float RoundScale(float scale) const {
+    const float limit =
+        std::floor(static_cast<float>(maxTextureSize) / static_cast<float>(largestCell) * ScaleSteps) / ScaleSteps;
+    return std::min(std::max(std::ceil(scale * ScaleSteps) / ScaleSteps, 1.0f / ScaleSteps), limit);
+  }
+  [[nodiscard]] float Scale() const { return resolvedScale; }
+
+  // Resolves and uploads the textures for `scale` in one go, on the main thread
+  bool SetScale(SDL_Renderer *renderer, float scale) {
+    scale = RoundScale(scale);
+    if (!pages.empty() && scale == resolvedScale) return true;
+    std::optional<Resolved> resolved = Resolve(scale);
+    return resolved && Upload(renderer, *resolved);
+  }
+
+  // The pages for `scale` (from RoundScale()). Only reads what Init() wrote, so it may run on another thread while the
+  // atlas draws; returns nothing if `stop` is requested first.
+  [[nodiscard]] std::optional<Resolved> Resolve(float scale, std::stop_token stop = {}) const {
+    Resolved resolved;
+    resolved.scale = scale;
+    // Each cell is resolved with its margin, which keeps filtering from reaching into the next cell. The cells are
+    // packed in rows, and a page is started where the next row would leave the texture size limit.
+    std::array<SDL_Rect, Glyphs.size()> boxes;
+    std::vector<SDL_Point> pageSizes(1);
+    int x = 0, y = 0, rowHeight = 0;
+    for (size_t g = 0; g < Glyphs.size(); ++g) {
+      const SDL_Rect &cell = glyphs[g].cell;
+      const auto w = static_cast<int>(std::ceil(static_cast<float>(cell.w + 2 * Spread) * scale));
+      const auto h = static_cast<int>(std::ceil(static_cast<float>(cell.h + 2 * Spread) * scale));
+      if (x > 0 && x + w > maxTextureSize) {
+        x = 0;
+        y += rowHeight;
+        rowHeight = 0;
+      }
+      if (y > 0 && y + h > maxTextureSize) {
+        pageSizes.push_back({0, 0});
+        y = 0;
+      }
+      boxes[g] = {x, y, w, h};
+      resolved.placements[g].page = pageSizes.size() - 1;
+      x += w;
+      rowHeight = std::max(rowHeight, h);
+      pageSizes.back().x = std::max(pageSizes.back().x, x);
+      pageSizes.back().y = std::max(pageSizes.back().y, y + rowHeight);
+    }
+
+    for (const SDL_Point &size : pageSizes) {
+      resolved.pages.emplace_back(SDL_CreateSurface(size.x, size.y, SDL_PIXELFORMAT_ARGB8888));
+      if (!resolved.pages.back() || !SDL_LockSurface(resolved.pages.back().get())) return std::nullopt;
+    }
+    bool done = true;
+    for (size_t g = 0; g < Glyphs.size() && done; ++g) {
+      Placement &placement = resolved.placements[g];
+      SDL_Surface *page = resolved.pages[placement.page].get();
+      const SDL_Rect &box = boxes[g], &cell = glyphs[g].cell;
+      Uint8 *pixels = static_cast<Uint8 *>(page->pixels) + static_cast<ptrdiff_t>(box.y) * page->pitch + box.x * 4;
+      done = ResolveCell(cell, scale, pixels, page->pitch, box.w, box.h, stop);
+      const float left = static_cast<float>(box.x) + Spread * scale, top = static_cast<float>(box.y) + Spread * scale;
+      placement.u0 = left / static_cast<float>(page->w);
+      placement.v0 = top / static_cast<float>(page->h);
+      placement.u1 = (left + static_cast<float>(cell.w) * scale) / static_cast<float>(page->w);
+      placement.v1 = (top + static_cast<float>(cell.h) * scale) / static_cast<float>(page->h);
+    }
+    for (const SurfacePtr &page : resolved.pages) SDL_UnlockSurface(page.get());
+    if (!done) return std::nullopt;
+    return resolved;
+  }
+
+  // Main thread. Keeps drawing from the previous textures, if any, when this fails.
+  bool Upload(SDL_Renderer *renderer, const Resolved &resolved) {
+    std::vector<TexturePtr> uploaded;
+    for (const SurfacePtr &page : resolved.pages) {
+      uploaded.emplace_back(CreateTextureFromSurface(renderer, page.get()));
+      if (!uploaded.back()) return false;
+      SDL_SetTextureBlendMode(uploaded.back().get(), SDL_BLENDMODE_BLEND);
+    }
+    pages = std::move(uploaded);
+    for (size_t g = 0; g < Glyphs.size(); ++g) glyphs[g].placement = resolved.placements[g];
+    resolvedScale = resolved.scale;
+    return true;
+  }
+
+  [[nodiscard]] int Height() const { return height; }
+
+  // Width of `text` set with the atlas' advances and kerning
+  [[nodiscard]] int Measure(std::string_view text) const {
+    return Layout(text, [](const Glyph &, int) {});
+  }
+
+  // Appends a quad per character of `text`, with the top left of the run at (x, y)
+  void Emit(std::string_view text, float x, float y, SDL_FColor color, Quads &out) const {
+    Layout(text, [&](const Glyph &glyph, int pen) {
+      const SDL_Rect &cell = glyph.cell;
+      const Placement &at = glyph.placement;
+      const auto base = static_cast<int>(out.positions.size() / 2);
+      const float left = x + static_cast<float>(pen), right = left + static_cast<float>(cell.w);
+      const float bottom = y + static_cast<float>(cell.h);
+      out.positions.insert(out.positions.end(), {left, y, right, y, right, bottom, left, bottom});
+      out.uvs.insert(out.uvs.end(), {at.u0, at.v0, at.u1, at.v0, at.u1, at.v1, at.u0, at.v1});
+      out.colors.insert(out.colors.end(), 4, color);
+      if (out.runs.empty() || out.runs.back().page != at.page) {
+        out.runs.push_back({at.page, static_cast<int>(out.indices.size()), 0});
+      }
+      for (int i : {0, 1, 2, 2, 3, 0}) out.indices.push_back(base + i);
+      out.runs.back().count += 6;
+    });
+  }
+
+  // The column tops of `text` as if it had been rendered as one surface
+  void ComposeColumnTops(std::string_view text, std::vector<float> &columnTops) const {
+    columnTops.assign(static_cast<size_t>(Measure(text)), std::numeric_limits<float>::infinity());
+    Layout(text, [&](const Glyph &glyph, int pen) {
+      for (size_t c = 0; c < glyph.columnTops.size(); ++c) {
+        const auto column = static_cast<size_t>(pen) + c;
+        if (column < columnTops.size()) columnTops[column] = std::min(columnTops[column], glyph.columnTops[c]);
+      }
+    });
+  }
+
+  void Draw(SDL_Renderer *renderer, const Quads &quads) const {
+    for (const Quads::Run &run : quads.runs) {
+      if (run.page >= pages.size()) continue;
+      SDL_RenderGeometryRaw(renderer, pages[run.page].get(), quads.positions.data(), 2 * sizeof(float),
+                            quads.colors.data(), sizeof(SDL_FColor), quads.uvs.data(), 2 * sizeof(float),
+                            static_cast<int>(quads.colors.size()), quads.indices.data() + run.first, run.count,
+                            sizeof(int));
+    }
+  }
+
+private:
+  static constexpr int Spread = 8;          // logical px the distance field reaches beyond the outlines
+  static constexpr float ScaleSteps = 8.0f; // scales are rounded up to eighths so resizes rarely resolve again
+  static constexpr float FarAway = 1e20f;   // squared distance standing in for infinity
+  static constexpr Sint64 DefaultMaxTextureSize = 2048;
+
+  struct Glyph {
+    SDL_Rect cell{}; // in the sheet; also the size of the quad
+    Placement placement;
+    int advance = 0;
+    std::vector<float> columnTops;
+  };
+
+  // Writes the signed distance to the outline of `surface`'s glyph (positive inside), for every texel of `cell` and
+  // its margin. Texels on the anti-aliased edge take their distance from their coverage.
+  bool StoreDistances(SDL_Surface *surface, const SDL_Rect &cell) {
+    const int w = cell.w + 2 * Spread, h = cell.h + 2 * Spread;
+    std::vector<Uint8> alpha(static_cast<size_t>(w) * h, 0);
+    if (!SDL_LockSurface(surface)) return false;
+    for (int y = 0; y < surface->h; ++y) {
+      const auto *row = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(surface->pixels) +
+                                                          static_cast<ptrdiff_t>(y) * surface->pitch);
+      for (int x = 0; x < surface->w; ++x) alpha[(y + Spread) * w + x + Spread] = static_cast<Uint8>(row[x] >> 24);
+    }
+    SDL_UnlockSurface(surface);
+
+    std::vector<float> toInside(alpha.size()), toOutside(alpha.size());
+    for (size_t i = 0; i < alpha.size(); ++i) {
+      const bool inside = alpha[i] >= 128;
+      toInside[i] = inside ? 0.0f : FarAway;
+      toOutside[i] = inside ? FarAway : 0.0f;
+    }
+    DistanceTransform(toInside, w, h);
+    DistanceTransform(toOutside, w, h);
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        const size_t i = static_cast<size_t>(y) * w + x;
+        // Texel centres are half a texel from an outline that runs between them
+        float distance = std::sqrt(toOutside[i]) - std::sqrt(toInside[i]) + (alpha[i] >= 128 ? -0.5f : 0.5f);
+        if (alpha[i] > 0 && alpha[i] < 255) distance = alpha[i] / 255.0f - 0.5f;
+        const float encoded = 128.0f + distance * (127.0f / Spread);
+        field[static_cast<size_t>(cell.y - Spread + y) * sheetWidth + cell.x - Spread + x] =
+            static_cast<Uint8>(std::clamp(std::lround(encoded), 0L, 255L));
+      }
+    }
+    return true;
+  }
+
+  // Squared Euclidean distance to the nearest zero of `grid`, in place: a pass over the columns, then one over the
+  // rows, each the lower envelope of parabolas of Felzenszwalb and Huttenlocher
+  static void DistanceTransform(std::vector<float> &grid, int w, int h) {
+    const size_t longest = static_cast<size_t>(std::max(w, h));
+    std::vector<float> line(longest), envelope(longest + 1);
+    std::vector<int> apex(longest);
+    auto transform = [&](float *f, int n, int stride) {
+      for (int q = 0; q < n; ++q) line[q] = f[q * stride];
+      int k = 0;
+      apex[0] = 0;
+      envelope[0] = -FarAway;
+      envelope[1] = FarAway;
+      for (int q = 1; q < n; ++q) {
+        float s;
+        while (true) {
+          const int p = apex[k];
+          s = ((line[q] + q * q) - (line[p] + p * p)) / (2.0f * (q - p));
+          if (s > envelope[k] || k == 0) break;
+          k--;
+        }
+        k++;
+        apex[k] = q;
+        envelope[k] = s;
+        envelope[k + 1] = FarAway;
+      }
+      k = 0;
+      for (int q = 0; q < n; ++q) {
+        while (envelope[k + 1] < q) k++;
+        const int p = apex[k];
+        f[q * stride] = static_cast<float>((q - p) * (q - p)) + line[p];
+      }
+    };
+    for (int x = 0; x < w; ++x) transform(&grid[x], h, w);
+    for (int y = 0; y < h; ++y) transform(&grid[static_cast<size_t>(y) * w], w, 1);
+  }
+
+  // Coverage of the w x h texels at `pixels` that `cell` and its margin resolve to at `scale`, from the bilinearly
+  // sampled field; false if stopped part way. With an outline the coverage of the glyph grown by
+  // Config::time_outline_width is the alpha, and the colour fades from white inside to black on the outline.
+  bool ResolveCell(const SDL_Rect &cell, float scale, Uint8 *pixels, int pitch, int w, int h,
+                   const std::stop_token &stop) const {
+    const float perCode = Spread / 127.0f * scale; // output px per step of the encoded distance
+    const float outline = Config::time_outline_width * scale;
+    auto sample = [&](float sx, float sy) {
+      sx = std::clamp(sx, 0.0f, static_cast<float>(sheetWidth - 1));
+      sy = std::clamp(sy, 0.0f, static_cast<float>(sheetHeight - 1));
+      const int x0 = static_cast<int>(sx), y0 = static_cast<int>(sy);
+      const int x1 = std::min(x0 + 1, sheetWidth - 1), y1 = std::min(y0 + 1, sheetHeight - 1);
+      const float fx = sx - x0, fy = sy - y0;
+      const Uint8 *top = &field[static_cast<size_t>(y0) * sheetWidth];
+      const Uint8 *bottom = &field[static_cast<size_t>(y1) * sheetWidth];
+      const float upper = top[x0] + (top[x1] - top[x0]) * fx, lower = bottom[x0] + (bottom[x1] - bottom[x0]) * fx;
+      return upper + (lower - upper) * fy - 128.0f;
+    };
+    const auto originX = static_cast<float>(cell.x - Spread) - 0.5f;
+    const auto originY = static_cast<float>(cell.y - Spread) - 0.5f;
+    for (int y = 0; y < h; ++y) {
+      if (stop.stop_requested()) return false;
+      auto *row = reinterpret_cast<Uint32 *>(pixels + static_cast<ptrdiff_t>(y) * pitch);
+      const float sy = originY + (y + 0.5f) / scale;
+      for (int x = 0; x < w; ++x) {
+        const float distance = sample(originX + (x + 0.5f) / scale, sy) * perCode; // in output px
+        const float fill = std::clamp(distance + 0.5f, 0.0f, 1.0f);
+        const float edge = std::clamp(distance + outline + 0.5f, 0.0f, 1.0f);
+        const auto a = static_cast<Uint32>(std::lround(edge * 255.0f));
+        const auto c = edge > 0.0f ? static_cast<Uint32>(std::lround(fill / edge * 255.0f)) : 255u;
+        row[x] = (a << 24) | (c << 16) | (c << 8) | c;
+      }
+    }
+    return true;
+  }
+
+  // Calls `place(glyph, pen)` for each character of `text` and returns the width of the run; characters outside
+  // Glyphs are skipped
+  template <typename Place> int Layout(std::string_view text, Place &&place) const {
+    int pen = 0, width = 0;
+    size_t previous = Glyphs.size();
+    for (char ch : text) {
+      const size_t g = Glyphs.find(ch);
+      if (g == std::string_view::npos) continue;
+      if (previous < Glyphs.size()) pen += kerning[previous][g];
+      place(glyphs[g], pen);
+      width = std::max(width, pen + glyphs[g].cell.w);
+      pen += glyphs[g].advance;
+      previous = g;
+    }
+    return std::max(width, pen);
+  }
+
+  std::vector<TexturePtr> pages;
+  std::array<Glyph, Glyphs.size()> glyphs;
+  std::array<std::array<int, Glyphs.size()>, Glyphs.size()> kerning{};
+  std::vector<Uint8> field; // signed distance per sheet texel: 128 on the outline, +-127 at +-Spread
+  int sheetWidth = 0, sheetHeight = 0;
+  int largestCell = 0; // side of the largest cell with its margins, in sheet texels
+  int maxTextureSize = 0;
+  float resolvedScale = 0.0f;
+  int height = 0;
+};
+
+// Placement of the label stack. Each node is centred horizontally and anchored vertically: at a fixed y, on the middle
+// of the screen, or below another node. A node is laid out again only when its own size changed or the node it hangs
+// from changed, and its rect is kept until then.
+class LabelLayout {
+public:
+  using Node = size_t;
+  enum class Anchor { Top, Middle, Below };
+
+  LabelLayout(float width, float height) : width(width), height(height) {}
+
+  // `offset` is the y for Top, and the distance from the middle or from the bottom of `parent` otherwise. A parent has
+  // to be added before its children, which keeps the nodes in dependency order.
+  Node Add(Anchor anchor, float offset, Node parent = 0) {
+    nodes.push_back({.anchor = anchor, .offset = offset, .parent = parent});
+    return nodes.size() - 1;
+  }
+
+  void SetSize(Node node, float w, float h) {
+    Item &item = nodes[node];
+    if (item.w == w && item.h == h) return;
+    item.w = w;
+    item.h = h;
+    item.dirty = true;
+  }
+
+  // Lays out the dirty nodes and the ones below them, and calls `changed(node, rect)` for every rect that differs from
+  // the last one. Returns whether there was any.
+  template <typename Changed> bool Resolve(Changed &&changed) {
+    bool any = false;
+    for (Node node = 0; node < nodes.size(); ++node) {
+      Item &item = nodes[node];
+      item.changed = false;
+      if (item.anchor == Anchor::Below && nodes[item.parent].changed) item.dirty = true;
+      if (!item.dirty) continue;
+      item.dirty = false;
+      SDL_FRect rect{(width - item.w) / 2.0f, item.offset, item.w, item.h};
+      if (item.anchor == Anchor::Middle) {
+        rect.y += (height - item.h) / 2.0f;
+      } else if (item.anchor == Anchor::Below) {
+        rect.y += nodes[item.parent].rect.y + nodes[item.parent].rect.h;
+      }
+      if (rect.x == item.rect.x && rect.y == item.rect.y && rect.w == item.rect.w && rect.h == item.rect.h) continue;
+      item.rect = rect;
+      item.changed = any = true;
+      changed(node, rect);
+    }
+    return any;
+  }
+
+private:
+  struct Item {
+    Anchor anchor;
+    float offset;
+    Node parent;
+    float w = 0.0f, h = 0.0f; // as last set
+    SDL_FRect rect{};         // as last resolved
+    bool dirty = true;
+    bool changed = false; // during Resolve()
+  };
+
+  float width, height;
+  std::vector<Item> nodes;
+};
+
+// Paces frames to a target rate. Prefers the display's VSync (SDL_RenderPresent blocks), then SDL's main callback
+// rate hint, and as a last resort sleeps against an absolute deadline schedule so that the time spent updating and
+// rendering is absorbed into the frame period instead of being added on top of it.
+class FramePacer {
+public:
+  enum class Mode { VSync, CallbackRate, Deadline };
+
+  struct Stats {
+    Uint64 frames = 0;
+    Uint64 missedDeadlines = 0; // frames that took more than 1.5 periods
+    double meanIntervalMs = 0.0;
+    double jitterMs = 0.0; // moving average of |interval - period|
+  };
+
+  void Init(SDL_Window *w, SDL_Renderer *r, double targetHz, bool preferVSync) {
+    window = w;
+    renderer = r;
+    allowVSync = preferVSync;
+    SetTargetRate(targetHz);
+    Resync();
+  }
+
+  // May be called at any time, e.g. by a governor lowering the frame rate
+  void SetTargetRate(double hz) {
+    targetHz = std::max(hz, 1.0);
+    periodNs = static_cast<Uint64>(1e9 / targetHz);
+
+    if (allowVSync && renderer) {
+      float refreshHz = 0.0f;
+      if (const SDL_DisplayMode *dm = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window))) {
+        refreshHz = dm->refresh_rate;
+      }
+      // Present every Nth vblank. A target between two such rates (the governor's 45 Hz on a 60 Hz display) would
+      // be rounded to one of them, so it is paced against deadlines instead.
+      const double vblanks = refreshHz > 0.0f ? refreshHz / targetHz : 1.0;
+      const int interval = std::max(1, static_cast<int>(std::lround(vblanks)));
+      if (vblanks > 1.0 && std::abs(vblanks - interval) > VBlankTolerance * vblanks) {
+        SDL_SetRenderVSync(renderer, SDL_RENDERER_VSYNC_DISABLED);
+        SetCallbackRateHint(0.0);
+        mode = Mode::Deadline;
+        return;
+      }
+      if (SDL_SetRenderVSync(renderer, interval)) {
+        if (refreshHz > 0.0f) periodNs = static_cast<Uint64>(1e9 * interval / refreshHz);
+        SetCallbackRateHint(0.0);
+        mode = Mode::VSync;
+        return;
+      }
+    }
+    if (renderer) SDL_SetRenderVSync(renderer, SDL_RENDERER_VSYNC_DISABLED);
+    mode = SetCallbackRateHint(targetHz) ? Mode::CallbackRate : Mode::Deadline;
+  }
+
+  // Blocks until the next frame is due (only in Deadline mode) and returns the seconds since the previous frame
+  double WaitForNextFrame() {
+    Uint64 now = SDL_GetTicksNS();
+    if (mode == Mode::Deadline) {
+      if (now < nextDeadlineNs) {
+        SDL_DelayPrecise(nextDeadlineNs - now);
+        now = SDL_GetTicksNS();
+      } else if (now - nextDeadlineNs > periodNs) {
+        // More than a whole frame late: drop the missed slots rather than bursting frames to catch up
+        nextDeadlineNs = now;
+      }
+      nextDeadlineNs += periodNs;
+    }
+
+    const Uint64 intervalNs = now - lastFrameNs;
+    lastFrameNs = now;
+    RecordInterval(intervalNs);
+    return static_cast<double>(intervalNs) / 1e9;
+  }
+
+  // Restart the schedule after the main loop slept on purpose, so the pause isn't counted as a missed frame
+  void Resync() {
+    lastFrameNs = SDL_GetTicksNS();
+    nextDeadlineNs = lastFrameNs;
+    skipNextInterval = true;
+  }
+
+  [[nodiscard]] Mode GetMode() const { return mode; }
+  [[nodiscard]] double GetTargetRate() const { return targetHz; }
+  [[nodiscard]] const Stats &GetStats() const { return stats; }
+
+  static const char *ModeName(Mode m) {
+    switch (m) {
+    case Mode::VSync:
+      return "vsync";
+    case Mode::CallbackRate:
+      return "callback-rate";
+    case Mode::Deadline:
+      return "deadline";
+    }
+    return "?";
+  }
+
+private:
+  static constexpr double VBlankTolerance = 0.02; // 59.94 Hz displays still count as 60 Hz ones
+
+  SDL_Window *window = nullptr;
+  SDL_Renderer *renderer = nullptr;
+  bool allowVSync = true;
+  Mode mode = Mode::Deadline;
+  double targetHz = 60.0;
+  Uint64 periodNs = 16'666'667;
+  Uint64 lastFrameNs = 0;
+  Uint64 nextDeadlineNs = 0;
+  bool skipNextInterval = true;
+  Stats stats;
+
+  static bool SetCallbackRateHint(double hz) {
+    auto value = std::format("{}", hz);
+    return SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, hz > 0.0 ? value.c_str() : nullptr);
+  }
+
+  void RecordInterval(Uint64 intervalNs) {
+    if (skipNextInterval) {
+      skipNextInterval = false;
+      return;
+    }
+    constexpr double smoothing = 0.05;
+    const double intervalMs = static_cast<double>(intervalNs) / 1e6;
+    const double periodMs = static_cast<double>(periodNs) / 1e6;
+    if (stats.frames == 0) stats.meanIntervalMs = intervalMs;
+    stats.frames++;
+    if (intervalNs > periodNs + periodNs / 2) stats.missedDeadlines++;
+    stats.meanIntervalMs += (intervalMs - stats.meanIntervalMs) * smoothing;
+    stats.jitterMs += (std::abs(intervalMs - periodMs) - stats.jitterMs) * smoothing;
+  }
+};
+
+// Per-stage frame timings kept in a fixed-size ring. The main thread is the only writer and the dump thread reads
+// concurrently, so each slot is guarded by a sequence number instead of a lock: the writer never waits, and a reader
+// that races with it just skips the torn slot.
+class FrameProfiler {
+public:
+  enum class Stage : Uint8 {
+    SnowUpdate,
+    Background,
+    DateLabel,
+    TimeLabel,
+    WeatherLabel,
+    AdviceLabel,
+    Render,
+    Present,
+    Count
+  };
+  static constexpr size_t StageCount = static_cast<size_t>(Stage::Count);
+  static constexpr std::array<const char *, StageCount> StageNames = {
+      "snow_update", "background", "date_label", "time_label", "weather_label", "advice_label", "render", "present"};
+  static constexpr Uint64 Capacity = 1024; // power of two
+
+  struct Frame {
+    Uint64 index = 0;
+    Uint64 startNs = 0;
+    Uint32 totalNs = 0;
+    std::array<Uint32, StageCount> beginNs{}; // offset of the stage from the frame start
+    std::array<Uint32, StageCount> durationNs{};
+  };
+
+  class Scope {
+  public:
+    Scope(FrameProfiler &p, Stage s) : profiler(p), stage(s), begin(SDL_GetTicksNS()) {}
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope() { profiler.Record(stage, begin, SDL_GetTicksNS()); }
+
+  private:
+    FrameProfiler &profiler;
+    Stage stage;
+    Uint64 begin;
+  };
+
+  FrameProfiler() = default;
+  FrameProfiler(const FrameProfiler &) = delete;
+  FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+  ~FrameProfiler() {
+    if (dumpThread.joinable()) {
+      dumpThread.request_stop();
+      dumpThread.join();
+      std::signal(dumpSignal, SIG_DFL);
+      signalFd.store(-1);
+      close(eventFd);
+    }
+  }
+
+  [[nodiscard]] Scope Measure(Stage stage) { return Scope(*this, stage); }
+
+  void BeginFrame() {
+    current = Frame{};
+    current.index = framesWritten.load(std::memory_order_relaxed);
+    current.startNs = SDL_GetTicksNS();
+  }
+
+  void EndFrame() {
+    current.totalNs = static_cast<Uint32>(SDL_GetTicksNS() - current.startNs);
+    Slot &slot = slots[current.index & (Capacity - 1)];
+    slot.sequence.store(current.index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.startNs.store(current.startNs, std::memory_order_relaxed);
+    slot.totalNs.store(current.totalNs, std::memory_order_relaxed);
+    for (size_t i = 0; i < StageCount; ++i) {
+      slot.beginNs[i].store(current.beginNs[i], std::memory_order_relaxed);
+      slot.durationNs[i].store(current.durationNs[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(current.index * 2 + 2, std::memory_order_release);
+    framesWritten.store(current.index + 1, std::memory_order_release);
+  }
+
+  [[nodiscard]] Uint64 FramesWritten() const { return framesWritten.load(std::memory_order_acquire); }
+
+  // Safe from any thread. Fails if the frame was overwritten or is being written right now.
+  bool ReadFrame(Uint64 index, Frame &out) const {
+    const Slot &slot = slots[index & (Capacity - 1)];
+    const Uint64 expected = index * 2 + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+    out.index = index;
+    out.startNs = slot.startNs.load(std::memory_order_relaxed);
+    out.totalNs = slot.totalNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < StageCount; ++i) {
+      out.beginNs[i] = slot.beginNs[i].load(std::memory_order_relaxed);
+      out.durationNs[i] = slot.durationNs[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+  }
+
+  // Installs a handler for `signum` that makes a background thread dump the last `frames` frames to
+  // frame-profile-<pid>-<n>.csv and .trace.json (Chrome trace format) in the working directory.
+  bool DumpOnSignal(int signum, int frames) {
+    eventFd = eventfd(0, EFD_CLOEXEC);
+    if (eventFd < 0) return false;
+    dumpSignal = signum;
+    dumpFrames = static_cast<Uint64>(std::clamp<int>(frames, 1, Capacity));
+    signalFd.store(eventFd);
+    std::signal(signum, &FrameProfiler::OnSignal);
+    dumpThread = std::jthread([this](std::stop_token stopToken) { DumpLoop(stopToken); });
+    return true;
+  }
+
+private:
+  struct Slot {
+    std::atomic<Uint64> sequence{0}; // odd while the main thread is writing it
+    std::atomic<Uint64> startNs{0};
+    std::atomic<Uint32> totalNs{0};
+    std::array<std::atomic<Uint32>, StageCount> beginNs{};
+    std::array<std::atomic<Uint32>, StageCount> durationNs{};
+  };
+
+  std::array<Slot, Capacity> slots;
+  std::atomic<Uint64> framesWritten{0};
+  Frame current;
+
+  inline static std::atomic<int> signalFd{-1};
+  int eventFd = -1;
+  int dumpSignal = 0;
+  Uint64 dumpFrames = 0;
+  std::jthread dumpThread;
+
+  void Record(Stage stage, Uint64 begin, Uint64 end) {
+    const auto i = static_cast<size_t>(stage);
+    if (current.durationNs[i] == 0) current.beginNs[i] = static_cast<Uint32>(begin - current.startNs);
+    current.durationNs[i] += static_cast<Uint32>(end - begin);
+  }
 
-std::string getCurrentTime() {
-  auto t = std::time(nullptr);
-  auto tm = *std::localtime(&t);
-  return std::format("{}:{:02}", tm.tm_hour, tm.tm_min);
-}
+  static void OnSignal(int) {
+    const int savedErrno = errno;
+    const Uint64 one = 1;
+    if (int fd = signalFd.load(); fd >= 0) {
+      [[maybe_unused]] auto written = write(fd, &one, sizeof(one));
+    }
+    errno = savedErrno;
+  }
 
-std::string getCurrentDate() {
-  auto now = std::chrono::system_clock::now();
-  auto days = std::chrono::floor<std::chrono::days>(now);
-  std::chrono::year_month_day ymd{days};
-  std::chrono::weekday wd{days};
-  return std::format("{}, {} {} {} года", weekdays[wd.c_encoding()], static_cast<unsigned>(ymd.day()),
-                     months[static_cast<unsigned>(ymd.month()) - 1], static_cast<int>(ymd.year()));
-}
+  void DumpLoop(std::stop_token stopToken) {
+    std::stop_callback wake(stopToken, [this] {
+      const Uint64 one = 1;
+      [[maybe_unused]] auto written = write(eventFd, &one, sizeof(one));
+    });
+    int dumpCount = 0;
+    while (!stopToken.stop_requested()) {
+      pollfd pfd{eventFd, POLLIN, 0};
+      if (poll(&pfd, 1, -1) < 0 && errno != EINTR) break;
+      Uint64 pending;
+      if (read(eventFd, &pending, sizeof(pending)) != sizeof(pending) || stopToken.stop_requested()) continue;
+      Dump(std::format("frame-profile-{}-{}", getpid(), dumpCount++));
+    }
+  }
 
-class SnowSystem {
+  void Dump(const std::string &baseName) const {
+    std::vector<Frame> frames;
+    frames.reserve(dumpFrames);
+    const Uint64 end = FramesWritten();
+    const Uint64 begin = end > dumpFrames ? end - dumpFrames : 0;
+    for (Uint64 i = begin; i < end; ++i) {
+      Frame f;
+      if (ReadFrame(i, f)) frames.push_back(f);
+    }
+    if (frames.empty()) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Profiler: no frames recorded yet");
+      return;
+    }
+
+    std::ofstream csv(baseName + ".csv");
+    csv << "frame,start_ms,total_ms";
+    for (const char *name : StageNames) csv << ',' << name << "_ms";
+    csv << '\n';
+    for (const auto &f : frames) {
+      auto out = std::format_to(std::ostreambuf_iterator<char>(csv), "{},{:.3f},{:.3f}", f.index, f.startNs / 1e6,
+                                f.totalNs / 1e6);
+      for (Uint32 d : f.durationNs) out = std::format_to(out, ",{:.3f}", d / 1e6);
+      csv << '\n';
+    }
+
+    // Chrome trace "complete" events, loadable in chrome://tracing or ui.perfetto.dev
+    std::ofstream trace(baseName + ".trace.json");
+    auto out = std::ostreambuf_iterator<char>(trace);
+    out = std::format_to(out, "{{\"traceEvents\":[");
+    bool first = true;
+    auto emit = [&](std::string_view name, Uint64 tsNs, Uint64 durNs, Uint64 frame) {
+      out = std::format_to(out, "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":{:.3f},\"dur\":{:.3f},"
+                                "\"args\":{{\"frame\":{}}}}}",
+                           first ? "" : ",", name, tsNs / 1e3, durNs / 1e3, frame);
+      first = false;
+    };
+    for (const auto &f : frames) {
+      emit("frame", f.startNs, f.totalNs, f.index);
+      for (size_t i = 0; i < StageCount; ++i) {
+        if (f.durationNs[i] > 0) emit(StageNames[i], f.startNs + f.beginNs[i], f.durationNs[i], f.index);
+      }
+    }
+    out = std::format_to(out, "],\"displayTimeUnit\":\"ms\"}}\n");
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Profiler: dumped %zu frames to %s.csv and %s.trace.json",
+                frames.size(), baseName.c_str(), baseName.c_str());
+  }
+};
+
+// Holds a frame cost budget on slow boards by stepping through quality levels. Decisions are made once per window
+// of frames on its 90th percentile, with a lower threshold and a longer dwell for stepping back up than for stepping
+// down, so the level doesn't oscillate around the budget.
+class QualityGovernor {
 public:
-  struct Flake {
-    float x, y;
-    float size;
-    float speedY;
-    float swayPhase;
-    float swaySpeed;
-    float depth; // 0.0 (far) to 1.0 (near)
-    SDL_FColor color;
+  struct Level {
+    const char *name;
+    float snowFraction; // of Config::num_snowflakes
+    SDL_ScaleMode backgroundScaleMode;
+    double fpsFraction; // of Config::target_fps
+
+    [[nodiscard]] double Fps() const { return Config::target_fps * fpsFraction; }
   };
+  static constexpr std::array<Level, 5> Levels = {{
+      {"full", 1.0f, SDL_SCALEMODE_LINEAR, 1.0},
+      {"reduced snow", 0.6f, SDL_SCALEMODE_LINEAR, 1.0},
+      {"nearest background", 0.6f, SDL_SCALEMODE_NEAREST, 1.0},
+      {"low snow, 3/4 rate", 0.3f, SDL_SCALEMODE_NEAREST, 0.75},
+      {"minimal, half rate", 0.15f, SDL_SCALEMODE_NEAREST, 0.5},
+  }};
 
-  void Init(int width, int height, int count = 200) {
-    screenWidth = (float)width;
-    screenHeight = (float)height;
+  explicit QualityGovernor(double budget) : budgetMs(budget) {}
 
-    flakes.resize(count);
-    vertices.resize(count * 4);
-    indices.resize(count * 6);
+  // Feed the CPU cost of one rendered frame. Returns true when the level changed and has to be applied.
+  bool AddFrame(double costMs) {
+    window[windowFill++] = static_cast<float>(costMs);
+    if (windowFill < window.size()) return false;
+    windowFill = 0;
 
-    std::vector<int> indexPattern = {0, 1, 2, 2, 3, 0};
-    for (size_t i = 0; i < flakes.size(); ++i) {
-      int vStart = static_cast<int>(i * 4);
-      int iStart = static_cast<int>(i * 6);
-      for (int k = 0; k < 6; ++k) {
-        indices[iStart + k] = vStart + indexPattern[k];
-      }
+    auto sorted = window;
+    auto p90 = sorted.begin() + static_cast<std::ptrdiff_t>(sorted.size() * 9 / 10);
+    std::nth_element(sorted.begin(), p90, sorted.end());
+    const double p90Ms = *p90;
+
+    const double budget = BudgetFor(level);
+    if (p90Ms > budget) {
+      overWindows++;
+      underWindows = 0;
+    } else if (level > 0 && p90Ms < UpgradeHeadroom * BudgetFor(level - 1)) {
+      underWindows++;
+      overWindows = 0;
+    } else {
+      overWindows = underWindows = 0;
     }
-    std::mt19937 gen(std::random_device{}());
-    for (auto &f : flakes) {
-      ResetFlake(f, gen, true);
+
+    if (overWindows >= DegradeAfterWindows && level + 1 < Levels.size()) {
+      ChangeLevel(level + 1, p90Ms, budget);
+      return true;
+    }
+    if (underWindows >= UpgradeAfterWindows) {
+      ChangeLevel(level - 1, p90Ms, budget);
+      return true;
     }
+    return false;
   }
 
-  void Update(double dt) {
-    windTimer += dt;
-    const float slowWind = 20.0f * std::sin((float)windTimer * 0.5f);
-    const float gustWind = 10.0f * std::sin((float)windTimer * 2.5f);
-    const float currentWind = slowWind + gustWind + 5.0f;
-    const float fDt = static_cast<float>(dt);
-
-    std::for_each(std::execution::par_unseq, flakes.begin(), flakes.end(), [&, this](Flake &f) {
-      f.y += f.speedY * fDt;
-      float individualSway = std::sin((float)windTimer * f.swaySpeed + f.swayPhase) * (10.0f * (1.0f - f.depth));
-      f.x += (currentWind * f.depth + individualSway) * fDt;
-      if (f.y > screenHeight) {
-        f.y = -f.size;
-        f.x = std::fmod(f.x + 100.0f, screenWidth);
-      }
-      if (f.x > screenWidth)
-        f.x = -f.size;
-      else if (f.x < -f.size)
-        f.x = screenWidth;
-    });
+  [[nodiscard]] const Level &Current() const { return Levels[level]; }
 
-    auto indicesView = std::views::iota(size_t{0}, flakes.size()) | std::views::common;
-    std::for_each(std::execution::par_unseq, indicesView.begin(), indicesView.end(), [this](size_t i) {
-      const auto &f = flakes[i];
-      size_t vIdx = i * 4;
-      const float right = f.x + f.size;
-      const float bottom = f.y + f.size;
-      vertices[vIdx + 0].position = {f.x, f.y};
-      vertices[vIdx + 0].color = f.color;
-      vertices[vIdx + 1].position = {right, f.y};
-      vertices[vIdx + 1].color = f.color;
-      vertices[vIdx + 2].position = {right, bottom};
-      vertices[vIdx + 2].color = f.color;
-      vertices[vIdx + 3].position = {f.x, bottom};
-      vertices[vIdx + 3].color = f.color;
-    });
+private:
+  static constexpr int DegradeAfterWindows = 2;
+  static constexpr int UpgradeAfterWindows = 5;
+  static constexpr double UpgradeHeadroom = 0.6;
+
+  double budgetMs;
+  size_t level = 0;
+  std::array<float, 60> window{};
+  size_t windowFill = 0;
+  int overWindows = 0;
+  int underWindows = 0;
+
+  // A lower frame rate gives every frame more time, but never less than the configured budget
+  [[nodiscard]] double BudgetFor(size_t l) const { return std::max(budgetMs, 0.85 * 1000.0 / Levels[l].Fps()); }
+
+  void ChangeLevel(size_t newLevel, double p90Ms, double budget) {
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Quality: %s -> %s (p90 frame cost %.2f ms, budget %.2f ms)",
+                Levels[level].name, Levels[newLevel].name, p90Ms, budget);
+    level = newLevel;
+    overWindows = underWindows = 0;
   }
+};
 
-  void Draw(SDL_Renderer *renderer) {
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_RenderGeometry(renderer, nullptr, vertices.data(), static_cast<int>(vertices.size()), indices.data(),
-                       static_cast<int>(indices.size()));
+// Command line options. `--bench[=frames]` renders that many frames offscreen (software renderer, no window, no
+// network) as fast as possible and prints a report; `--seed=<n>` fixes the snow layout. `--soak=<days>` runs
+// offscreen on generated data with the clock sped up by `--time-scale=<x>` and reports resource use per day; it starts
+// now, or at midnight UTC of `--soak-start=<yyyy-mm-dd>` to cover a given date such as a DST change.
+struct AppOptions {
+  int benchFrames = 0;
+  int soakDays = 0;
+  double timeScale = Config::soak_default_time_scale;
+  std::optional<std::chrono::sys_days> soakStart;
+  int flakes = Config::num_snowflakes;
+  std::optional<unsigned> seed;
+  std::optional<SnowSystem::Backend> snowBackend; // calibrated at startup unless forced
+  SnowSystem::Motion snowMotion = SnowSystem::Motion::Stepped;
+
+  [[nodiscard]] bool Headless() const { return benchFrames > 0 || soakDays > 0; }
+
+  static AppOptions Parse(int argc, char *argv[]) {
+    AppOptions options;
+    auto parseNumber = [](std::string_view value, auto &out) {
+      auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), out);
+      return ec == std::errc{} && ptr == value.data() + value.size();
+    };
+    for (int i = 1; i < argc; ++i) {
+      std::string_view arg = argv[i];
+      if (arg == "--bench") {
+        options.benchFrames = Config::bench_default_frames;
+      } else if (arg.starts_with("--bench=")) {
+        if (!parseNumber(arg.substr(8), options.benchFrames) || options.benchFrames <= 0) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid frame count in %s", argv[i]);
+          options.benchFrames = Config::bench_default_frames;
+        }
+      } else if (arg.starts_with("--soak=")) {
+        if (!parseNumber(arg.substr(7), options.soakDays) || options.soakDays <= 0) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid day count in %s", argv[i]);
+          options.soakDays = 1;
+        }
+      } else if (arg.starts_with("--soak-start=")) {
+        const std::string_view value = arg.substr(13);
+        int year = 0;
+        unsigned month = 0, day = 0;
+        const bool parsed = value.size() == 10 && value[4] == '-' && value[7] == '-' &&
+                            parseNumber(value.substr(0, 4), year) && parseNumber(value.substr(5, 2), month) &&
+                            parseNumber(value.substr(8, 2), day);
+        const std::chrono::year_month_day date{std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+        if (parsed && date.ok()) {
+          options.soakStart = date;
+        } else {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid date in %s", argv[i]);
+        }
+      } else if (arg.starts_with("--time-scale=")) {
+        if (!parseNumber(arg.substr(13), options.timeScale) || options.timeScale <= 0.0) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid time scale in %s", argv[i]);
+          options.timeScale = Config::soak_default_time_scale;
+        }
+      } else if (arg.starts_with("--flakes=")) {
+        if (!parseNumber(arg.substr(9), options.flakes) || options.flakes < 0) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid flake count in %s", argv[i]);
+          options.flakes = Config::num_snowflakes;
+        }
+      } else if (arg.starts_with("--seed=")) {
+        unsigned value;
+        if (parseNumber(arg.substr(7), value)) {
+          options.seed = value;
+        } else {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid seed in %s", argv[i]);
+        }
+      } else if (arg.starts_with("--snow-motion=")) {
+        const auto &names = SnowSystem::MotionNames;
+        const auto it = std::ranges::find(names, arg.substr(14));
+        if (it != names.end()) {
+          options.snowMotion = static_cast<SnowSystem::Motion>(it - names.begin());
+        } else {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unknown snow motion in %s", argv[i]);
+        }
+      } else if (arg.starts_with("--snow-backend=")) {
+        const auto &names = SnowSystem::BackendNames;
+        const auto it = std::ranges::find(names, arg.substr(15));
+        if (it != names.end()) {
+          options.snowBackend = static_cast<SnowSystem::Backend>(it - names.begin());
+        } else {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unknown snow backend in %s", argv[i]);
+        }
+      } else {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring unknown argument %s", argv[i]);
+      }
+    }
+    return options;
+  }
+};
+
+// Collects profiler frames during a --bench run and prints throughput, per-stage percentiles and peak RSS
+class BenchmarkReport {
+public:
+  void Start(int frames) {
+    samples.clear();
+    samples.reserve(frames);
+    startNs = SDL_GetTicksNS();
+  }
+
+  // `allocations` is the number of heap allocations made during the frame
+  void AddFrame(const FrameProfiler::Frame &frame, Uint64 allocations) {
+    samples.push_back(frame);
+    if (samples.size() <= Config::bench_warmup_frames) return;
+    steadyAllocations += allocations;
+    if (allocations > 0) allocatingFrames++;
+  }
+
+  // Heap allocations after the warm-up frames; a steady frame makes none
+  [[nodiscard]] Uint64 SteadyAllocations() const { return steadyAllocations; }
+
+  void Print(const char *rendererName, unsigned seed, int flakes) const {
+    const double seconds = static_cast<double>(SDL_GetTicksNS() - startNs) / 1e9;
+    std::printf("bench: %zu frames in %.3f s -> %.1f frames/s (%s renderer, seed %u, %d flakes)\n", samples.size(),
+                seconds, seconds > 0.0 ? samples.size() / seconds : 0.0, rendererName, seed, flakes);
+    std::printf("%-16s %9s %9s %9s %9s\n", "stage", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    PrintStage("frame", [](const FrameProfiler::Frame &f) { return f.totalNs; });
+    for (size_t i = 0; i < FrameProfiler::StageCount; ++i) {
+      PrintStage(FrameProfiler::StageNames[i], [i](const FrameProfiler::Frame &f) { return f.durationNs[i]; });
+    }
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::printf("peak RSS: %.1f MiB\n", usage.ru_maxrss / 1024.0); // ru_maxrss is in KiB on Linux
+    if (Counters::countsAllocations) {
+      // Only operator new is counted, not SDL_malloc, as in TTF_SetTextString or TTF_GetTextSubStringsForRange
+      std::printf("heap allocations (operator new; SDL_malloc isn't counted) after %d warm-up frames: %llu in %llu "
+                  "frames\n",
+                  Config::bench_warmup_frames, static_cast<unsigned long long>(steadyAllocations),
+                  static_cast<unsigned long long>(allocatingFrames));
+    } else {
+      std::printf("heap allocations: not counted in this build (see CLOCK_COUNT_ALLOCATIONS)\n");
+    }
   }
 
 private:
-  float screenWidth = 0;
-  float screenHeight = 0;
-  double windTimer = 0.0;
-  std::vector<Flake> flakes;
-  std::vector<SDL_Vertex> vertices;
-  std::vector<int> indices;
-  std::uniform_real_distribution<float> distDepth{0.2f, 1.0f};
-  std::uniform_real_distribution<float> distPhase{0.0f, 2.0f * std::numbers::pi_v<float>};
+  std::vector<FrameProfiler::Frame> samples;
+  Uint64 startNs = 0;
+  Uint64 steadyAllocations = 0;
+  Uint64 allocatingFrames = 0;
+
+  template <typename Select> void PrintStage(const char *name, Select select) const {
+    if (samples.empty()) return;
+    std::vector<Uint32> values;
+    values.reserve(samples.size());
+    for (const auto &f : samples) values.push_back(select(f));
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](double p) {
+      auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+      return values[index] / 1e6;
+    };
+    std::printf("%-16s %9.3f %9.3f %9.3f %9.3f\n", name, percentile(0.50), percentile(0.95), percentile(0.99),
+                values.back() / 1e6);
+  }
+};
+
+// Tracks a --soak run and prints CPU time, heap allocations and texture creations for every simulated day
+class SoakReport {
+public:
+  void Start(VirtualClock::WallTime now, int totalDays) {
+    dayStart = runStart = now;
+    days = totalDays;
+    last = Sample::Take();
+  }
+
+  void AddFrame() { frames++; }
+
+  // Returns true once all days have been reported
+  bool Update(VirtualClock::WallTime now) {
+    while (now - dayStart >= std::chrono::days(1)) {
+      Sample current = Sample::Take();
+      char allocations[32] = "uncounted";
+      if (Counters::countsAllocations) {
+        std::snprintf(allocations, sizeof(allocations), "%llu",
+                      static_cast<unsigned long long>(current.allocations - last.allocations));
+      }
+      std::printf("soak day %d: %llu frames, cpu %.1f ms, %s allocations, %llu textures created, %d UTC offset "
+                  "changes, %d local time mismatches\n",
+                  ++day, static_cast<unsigned long long>(frames), (current.cpuNs - last.cpuNs) / 1e6, allocations,
+                  static_cast<unsigned long long>(current.textures - last.textures), offsetChanges,
+                  localTimeMismatches);
+      std::fflush(stdout);
+      last = current;
+      frames = 0;
+      dayStart += std::chrono::days(1);
+      if (day >= days) return true;
+    }
+    return false;
+  }
+
+  // Prints what the run covered and returns false if the clock showed a wrong local time at a checkpoint, the run
+  // spanned one without showing it (a time scale too high to see every minute), or, in the checkpoint zone, the run
+  // spanned none of them and so checked nothing
+  [[nodiscard]] bool Finish() const {
+    int missed = 0;
+    if constexpr (ChecksZone) {
+      for (size_t i = 0; i < Checkpoints.size(); ++i) {
+        if (!checkpointSeen[i] && Checkpoints[i].minute >= runStart && Checkpoints[i].minute < dayStart) missed++;
+      }
+    }
+    std::printf("soak: %d local time checkpoints shown, %d wrong, %d missed\n", checkpointsShown,
+                localTimeMismatches, missed);
+    if (ChecksZone && checkpointsShown == 0) {
+      std::printf("soak: no local time checkpoint in the run, start it with --soak-start=2026-03-28 or 2026-10-24\n");
+      return false;
+    }
+    return localTimeMismatches == 0 && missed == 0;
+  }
 
-  void ResetFlake(Flake &f, std::mt19937 &gen, bool randomizeY) {
-    std::uniform_real_distribution<float> distX(0.0f, screenWidth);
-    std::uniform_real_distribution<float> distY(-50.0f, screenHeight);
-    f.depth = distDepth(gen);
-    f.size = 2.0f + (f.depth * 3.0f);
-    f.speedY = 30.0f + (f.depth * 60.0f);
-    f.swayPhase = distPhase(gen);
-    f.swaySpeed = 1.0f + (f.depth * 2.0f);
-    f.x = distX(gen);
-    f.y = randomizeY ? distY(gen) : -f.size;
-    float alphaVal = 0.2f + (f.depth * 0.8f);
-    f.color = {1.0f, 1.0f, 1.0f, alphaVal};
+  // Called whenever the time label changes, with the minute its strings were formatted for. Prints each change of the
+  // zone's UTC offset with what the clock shows after it, and compares the strings shown at the checkpoints with the
+  // ones expected there.
+  void CheckLocalTime(VirtualClock::WallTime minute, const std::string &time, const std::string &date) {
+    if constexpr (ChecksZone) {
+      for (size_t i = 0; i < Checkpoints.size(); ++i) {
+        const Checkpoint &checkpoint = Checkpoints[i];
+        if (checkpoint.minute != minute) continue;
+        checkpointSeen[i] = true;
+        checkpointsShown++;
+        if (time != checkpoint.time || date != checkpoint.date) {
+          localTimeMismatches++;
+          std::printf("soak: expected %s, %s but the clock shows %s, %s\n", checkpoint.time.data(),
+                      checkpoint.date.data(), time.c_str(), date.c_str());
+        }
+      }
+    }
+    const auto local = LocalTime::Get().Split(minute);
+    if (lastOffset && local.offset != *lastOffset) {
+      offsetChanges++;
+      std::printf("soak: UTC offset %+lld -> %+lld min, the clock shows %s, %s\n",
+                  static_cast<long long>(lastOffset->count() / 60), static_cast<long long>(local.offset.count() / 60),
+                  time.c_str(), date.c_str());
+    }
+    lastOffset = local.offset;
   }
+
+private:
+  struct Sample {
+    Uint64 cpuNs;
+    Uint64 allocations;
+    Uint64 textures;
+
+    static Sample Take() {
+      rusage usage{};
+      getrusage(RUSAGE_SELF, &usage);
+      auto toNs = [](const timeval &tv) { return Uint64(tv.tv_sec) * 1'000'000'000 + Uint64(tv.tv_usec) * 1'000; };
+      return {toNs(usage.ru_utime) + toNs(usage.ru_stime), Counters::allocations.load(),
+              Counters::texturesCreated.load()};
+    }
+  };
+
+  // What Europe/Amsterdam shows around the midnights and daylight saving changes of 2026, written out by hand rather
+  // than computed with the code under test. `--soak-start=2026-03-28 --soak=2` and `--soak-start=2026-10-24 --soak=2`
+  // cover them.
+  struct Checkpoint {
+    VirtualClock::WallTime minute; // UTC
+    std::string_view time;
+    std::string_view date;
+  };
+  // Gated on the configured name rather than the resolved zone's: tzdata may resolve it to a link target
+  // (Europe/Brussels since 2022b)
+  static constexpr bool ChecksZone = std::string_view(Config::time_zone) == "Europe/Amsterdam";
+  static inline const std::array<Checkpoint, 10> Checkpoints = [] {
+    using std::chrono::hours, std::chrono::minutes;
+    const std::chrono::sys_days march28{std::chrono::year{2026} / std::chrono::March / 28};
+    const std::chrono::sys_days october24{std::chrono::year{2026} / std::chrono::October / 24};
+    return std::array<Checkpoint, 10>{{
+        {march28 + hours(22) + minutes(59), "23:59", "суббота, 28 марта 2026 года"},
+        {march28 + hours(23), "0:00", "воскресенье, 29 марта 2026 года"},
+        {march28 + hours(24) + minutes(59), "1:59", "воскресенье, 29 марта 2026 года"},
+        {march28 + hours(25), "3:00", "воскресенье, 29 марта 2026 года"}, // CET -> CEST
+        {march28 + hours(45), "23:00", "воскресенье, 29 марта 2026 года"},
+        {october24 + hours(21) + minutes(59), "23:59", "суббота, 24 октября 2026 года"},
+        {october24 + hours(22), "0:00", "воскресенье, 25 октября 2026 года"},
+        {october24 + hours(24) + minutes(59), "2:59", "воскресенье, 25 октября 2026 года"},
+        {october24 + hours(25), "2:00", "воскресенье, 25 октября 2026 года"}, // CEST -> CET
+        {october24 + hours(47), "0:00", "понедельник, 26 октября 2026 года"},
+    }};
+  }();
+
+  VirtualClock::WallTime runStart;
+  VirtualClock::WallTime dayStart;
+  Sample last{};
+  Uint64 frames = 0;
+  int day = 0;
+  int days = 0;
+  std::optional<std::chrono::seconds> lastOffset;
+  int offsetChanges = 0;
+  std::array<bool, Checkpoints.size()> checkpointSeen{};
+  int checkpointsShown = 0;
+  int localTimeMismatches = 0;
 };
 
 class Clock {
@@ -274,22 +3545,35 @@ public:
   Clock(const Clock &) = delete;
   Clock &operator=(const Clock &) = delete;
 
-  bool Init() {
+  bool Init(const AppOptions &opts) {
+    options = opts;
     SDL_SetAppMetadata(Config::AppName, Config::AppVersion, nullptr);
-    if (!SDL_Init(SDL_INIT_VIDEO)) {
+    if (!SDL_Init(options.Headless() ? SDL_INIT_EVENTS : SDL_INIT_VIDEO)) {
       SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s", SDL_GetError());
       return false;
     }
+    // Resolved before any thread reads the local time (and, without tzdb, sets TZ while nothing else runs)
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Time zone: %s", LocalTime::Get().Name().c_str());
 
-    SDL_Window *w;
-    SDL_Renderer *r;
-    if (!SDL_CreateWindowAndRenderer(Config::AppName, Config::screen_width, Config::screen_height, SDL_WINDOW_RESIZABLE,
-                                     &w, &r)) {
-      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window/renderer: %s", SDL_GetError());
-      return false;
+    if (options.Headless()) {
+      // Software rendering into a plain surface: no window, display or GPU needed
+      offscreenSurface.reset(SDL_CreateSurface(Config::screen_width, Config::screen_height, SDL_PIXELFORMAT_XRGB8888));
+      if (offscreenSurface) renderer.reset(SDL_CreateSoftwareRenderer(offscreenSurface.get()));
+      if (!renderer) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create offscreen renderer: %s", SDL_GetError());
+        return false;
+      }
+    } else {
+      SDL_Window *w;
+      SDL_Renderer *r;
+      if (!SDL_CreateWindowAndRenderer(Config::AppName, Config::screen_width, Config::screen_height,
+                                       SDL_WINDOW_RESIZABLE, &w, &r)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window/renderer: %s", SDL_GetError());
+        return false;
+      }
+      window.reset(w);
+      renderer.reset(r);
     }
-    window.reset(w);
-    renderer.reset(r);
 
     if (!TTF_Init()) {
       SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL_ttf: %s", SDL_GetError());
@@ -305,6 +3589,22 @@ public:
       SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't load embedded font: %s", SDL_GetError());
       return false;
     }
+    normalGlyphs.Init(fontNormal.get());
+    smallGlyphs.Init(fontSmall.get());
+    textEngine.reset(TTF_CreateRendererTextEngine(renderer.get()));
+    if (!textEngine) {
+      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create text engine: %s", SDL_GetError());
+      return false;
+    }
+    if (!digitAtlas.Init(renderer.get(), fontBig.get())) {
+      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't build the clock digit atlas: %s", SDL_GetError());
+      return false;
+    }
+    // At startup the digits are resolved for the output right away; later sizes are resolved in the background
+    if (!digitAtlas.SetScale(renderer.get(), OutputScale())) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't resolve the clock digits: %s", SDL_GetError());
+    }
+    requestedDigitScale = digitAtlas.Scale();
 
     if (!SDL_SetRenderLogicalPresentation(renderer.get(), Config::screen_width, Config::screen_height,
                                           SDL_LOGICAL_PRESENTATION_LETTERBOX)) {
@@ -313,38 +3613,147 @@ public:
 #ifdef APP_DEBUG
     // Keep cursor visible in debug for easier window movement/closing
 #else
-    if (!SDL_HideCursor()) {
+    if (window && !SDL_HideCursor()) {
       SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't hide cursor: %s", SDL_GetError());
     }
 #endif
 
-    snow.Init(Config::screen_width, Config::screen_height, Config::num_snowflakes);
+    const int flakeCount = Config::snow_enabled ? options.flakes : 0;
+    const unsigned seed = options.Headless() ? options.seed.value_or(Config::bench_default_seed)
+                                             : options.seed.value_or(std::random_device{}());
+    snow.Init(renderer.get(), Config::screen_width, Config::screen_height, flakeCount, seed);
+    weatherEffects.Init(Config::screen_width, Config::screen_height, seed);
+    snow.SetMotion(options.snowMotion);
+    if (!options.snowBackend) {
+      snow.Calibrate();
+    } else if (!snow.SetBackend(*options.snowBackend)) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Snow backend %s isn't available, using %s",
+                  SnowSystem::BackendNames[static_cast<size_t>(*options.snowBackend)], snow.GetBackendName());
+    }
+    if (options.benchFrames > 0) return StartBenchmark();
+
+    // Data threads push this to wake the main loop out of an idle wait
+    wakeEventType = SDL_RegisterEvents(1);
 
     // Start Data Threads
-    bgLoaderThread = std::jthread(&Clock::FetchBackgroundImage, this);
-    weatherLoaderThread = std::jthread(&Clock::FetchWeather, this);
+    if (options.soakDays > 0) {
+      clock.StartScaled(options.soakStart ? VirtualClock::WallTime(*options.soakStart) : std::chrono::system_clock::now(),
+                        options.timeScale);
+      soakReport.Start(clock.Now(), options.soakDays);
+      dataThread = std::jthread([this](std::stop_token stopToken) { FeedSyntheticData(stopToken); });
+    } else {
+      bgLoaderThread = std::jthread([this](std::stop_token stopToken) { FetchBackgroundImage(stopToken); });
+      weatherLoaderThread = std::jthread([this](std::stop_token stopToken) { FetchWeather(stopToken); });
+    }
+    minuteClock.Start(clock, [this] { WakeMainLoop(); });
+
+    pacer.Init(window.get(), renderer.get(), Config::target_fps, Config::prefer_vsync && window);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Frame pacing: %s at %.1f Hz", FramePacer::ModeName(pacer.GetMode()),
+                pacer.GetTargetRate());
 
-    lastPerformanceCounter = SDL_GetPerformanceCounter();
+    if (!profiler.DumpOnSignal(SIGUSR1, Config::profile_dump_frames)) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't set up profiler dumps: %s", std::strerror(errno));
+    }
 
     return true;
   }
 
   SDL_AppResult Iterate() {
-    UpdateTiming();
-    snow.Update(deltaTime);
-    UpdateTextures();
-    Render();
+    frameStartAllocations = Counters::allocations.load(std::memory_order_relaxed);
+    if (options.benchFrames > 0) {
+      // Fixed step and a hand-stepped clock so runs are comparable
+      deltaTime = 1.0 / Config::target_fps;
+      clock.Advance(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(deltaTime)));
+      FeedBenchmarkData();
+      damaged = true;
+    } else {
+      UpdateTiming();
+    }
+    profiler.BeginFrame();
+    if (snow.IsAnimating() || weatherEffects.IsAnimating()) {
+      auto scope = profiler.Measure(FrameProfiler::Stage::SnowUpdate);
+      snow.Update(deltaTime);
+      weatherEffects.Update(deltaTime);
+      damaged = true;
+    }
+    if (UpdateTextures()) damaged = true;
+
+    const bool draw = damaged && windowVisible;
+    if (draw) {
+      Render();
+      damaged = false;
+    }
+    profiler.EndFrame();
+
+    if (options.benchFrames > 0) return FinishBenchmarkFrame();
+    if (options.soakDays > 0) {
+      if (draw) soakReport.AddFrame();
+      if (soakReport.Update(clock.Now())) return soakReport.Finish() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    } else if (draw && Config::adaptive_quality) {
+      GovernQuality();
+    }
+
+    if (!draw) WaitForDamage();
+    return SDL_APP_CONTINUE;
+  }
+
+  SDL_AppResult HandleEvent(const SDL_Event *event) {
+    switch (event->type) {
+    case SDL_EVENT_QUIT:
+      return SDL_APP_SUCCESS;
+    case SDL_EVENT_KEY_DOWN:
+      if (event->key.key == SDLK_SPACE && !event->key.repeat) {
+        snow.SetPaused(!snow.IsPaused());
+        weatherEffects.SetPaused(snow.IsPaused());
+        damaged = true;
+      }
+      break;
+    case SDL_EVENT_WINDOW_HIDDEN:
+    case SDL_EVENT_WINDOW_MINIMIZED:
+    case SDL_EVENT_WINDOW_OCCLUDED:
+      windowVisible = false;
+      break;
+    case SDL_EVENT_WINDOW_SHOWN:
+    case SDL_EVENT_WINDOW_RESTORED:
+    case SDL_EVENT_WINDOW_EXPOSED:
+      windowVisible = true;
+      damaged = true;
+      break;
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+    case SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED:
+      ScaleDigits();
+      damaged = true;
+      break;
+    case SDL_EVENT_WINDOW_RESIZED:
+    case SDL_EVENT_RENDER_DEVICE_RESET:
+      damaged = true;
+      break;
+    case SDL_EVENT_RENDER_TARGETS_RESET:
+      for (TextLabel *label : {&dateLabel, &weatherLabel, &adviceLabel}) label->compose(renderer.get());
+      damaged = true;
+      break;
+    default:
+      break;
+    }
     return SDL_APP_CONTINUE;
   }
 
 private:
+  AppOptions options;
   WindowPtr window;
   RendererPtr renderer;
+  SurfacePtr offscreenSurface;
   FontPtr fontBig;
   FontPtr fontNormal;
   FontPtr fontSmall;
+  GlyphColumnTops normalGlyphs;
+  GlyphColumnTops smallGlyphs;
+  TextEnginePtr textEngine;
 
+  VirtualClock clock;
+  MinuteClock minuteClock;
   SnowSystem snow;
+  WeatherEffects weatherEffects;
 
   // Background Image
   std::jthread bgLoaderThread;
@@ -357,69 +3766,230 @@ private:
   std::jthread weatherLoaderThread;
   std::mutex weatherMutex;
   std::string weatherString;
+  std::optional<CurrentWeather> weatherReport;
+  std::atomic<Uint64> weatherVersion{0};      // bumped under the mutex with every new report
+  Uint64 shownWeatherVersion = 0;             // main thread only
+  std::optional<CurrentWeather> shownWeather; // what the particles were last set up for, main thread only
 
   // Clothing Advice (LLM)
   std::mutex adviceMutex;
   std::string adviceString;
+  std::atomic<Uint64> adviceVersion{0};
+  Uint64 shownAdviceVersion = 0;
+
+  // Soak runs replace both fetch threads with generated data
+  std::jthread dataThread;
 
-  Uint64 lastPerformanceCounter = 0;
+  FramePacer pacer;
+  FrameProfiler profiler;
+  QualityGovernor governor{Config::frame_budget_ms};
+  BenchmarkReport benchReport;
+  int benchFramesDone = 0;
+  int benchDataChanges = 0;
+  static constexpr std::array<std::string_view, 2> BenchWeatherTexts = {"-3°C, сильный снегопад, ветер 7 м/с",
+                                                                        "-1°C, небольшой снегопад, ветер 3 м/с"};
+  static constexpr std::array<std::string_view, 3> BenchAdviceTexts = {
+      "Наденьте теплую зимнюю куртку, шапку, шарф и теплые ботинки.",
+      "Теплая куртка, перчатки и непромокаемая обувь.",
+      "Пуховик, вязаная шапка, варежки и зимние сапоги, а под куртку свитер."};
+  Uint64 frameStartAllocations = 0; // the allocation counter when the frame began
+  SoakReport soakReport;
   double fps = 0.0;
   double deltaTime = 0.0;
 
+  // Damage tracking: a frame is only rendered and presented when something on screen changed
+  Uint32 wakeEventType = 0;
+  bool damaged = true;
+  bool windowVisible = true;
+
+  // A label on SDL_ttf's renderer text engine. The engine keeps rasterized glyphs in atlas textures shared by every
+  // text of a font, so a new string is only laid out again: no surface is rendered. Text and shadow are then drawn
+  // once into a texture of the label, which frames draw with a single call and no color or alpha mod changes.
   struct TextLabel {
+    static constexpr float ShadowOffset = 1.0f;
+    static constexpr size_t TextCapacity = 256; // bytes; longer texts allocate when they arrive
+
     std::string text;
-    TexturePtr texture;
-    SDL_FRect rect;
+    TextPtr ttfText;
+    SDL_FRect rect{}; // size from update(), position from place()
+    SDL_Color color{};
+    // Text with its shadow; reused until a text outgrows it
+    TexturePtr composed;
+    int composedWidth = 0, composedHeight = 0;
+    SDL_FRect extent{}; // the part of `composed` in use
+    // Per pixel column, the top of the first glyph over it (infinity if none); snow settles on it
+    std::vector<float> columnTops;
     // Store last wrap width to detect changes needed if window resizes (though fixed logical size simplifies this)
     int lastWrapWidth = 0;
 
-    // Layout function to position the text label within the window
-    using LayoutFunc = std::function<SDL_FRect(float w, float h)>;
+    // Buffers are sized up front so that a new text doesn't allocate
+    TextLabel() {
+      text.reserve(TextCapacity);
+      columnTops.reserve(Config::screen_width);
+    }
+
+    [[nodiscard]] bool visible() const { return ttfText && !text.empty(); }
 
-    void update(SDL_Renderer *renderer, TTF_Font *font, std::string_view newText, SDL_Color color, LayoutFunc layout,
-                int wrapWidth = 0) {
-      if (text == newText && texture && wrapWidth == lastWrapWidth) return;
+    // Returns true when the label looks different and the screen needs a redraw
+    bool update(SDL_Renderer *renderer, TTF_TextEngine *engine, GlyphColumnTops &glyphs, std::string_view newText,
+                SDL_Color newColor, int wrapWidth = 0) {
+      if (text == newText && ttfText && wrapWidth == lastWrapWidth) return false;
       if (newText.empty()) {
-        texture.reset();
-        return;
+        bool hadText = visible();
+        text.clear();
+        columnTops.clear();
+        return hadText;
       }
       text = newText;
       lastWrapWidth = wrapWidth;
+      color = newColor;
 
-      SurfacePtr surf;
-      if (wrapWidth > 0) {
-        surf.reset(TTF_RenderText_Blended_Wrapped(font, text.c_str(), 0, color, wrapWidth));
+      if (ttfText) {
+        TTF_SetTextString(ttfText.get(), text.data(), text.size());
       } else {
-        surf.reset(TTF_RenderText_Blended(font, text.c_str(), 0, color));
+        ttfText.reset(TTF_CreateText(engine, glyphs.Font(), text.data(), text.size()));
+        if (!ttfText) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create text: %s", SDL_GetError());
+          return true;
+        }
+      }
+      TTF_SetTextWrapWidth(ttfText.get(), wrapWidth);
+      int w = 0, h = 0;
+      TTF_GetTextSize(ttfText.get(), &w, &h);
+      rect.w = (float)w;
+      rect.h = (float)h;
+      MeasureColumnTops(glyphs, w);
+      compose(renderer);
+      return true;
+    }
+
+    // Also needed when the renderer has lost the contents of its target textures
+    void compose(SDL_Renderer *renderer) {
+      if (!visible()) return;
+      extent = {0.0f, 0.0f, rect.w + ShadowOffset, rect.h + ShadowOffset};
+      const auto w = static_cast<int>(std::ceil(extent.w)), h = static_cast<int>(std::ceil(extent.h));
+      if (!composed || w > composedWidth || h > composedHeight) {
+        composedWidth = std::max(w, composedWidth);
+        composedHeight = std::max(h, composedHeight);
+        composed.reset(CreateTargetTexture(renderer, composedWidth, composedHeight));
+        if (!composed) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create label texture: %s", SDL_GetError());
+          return;
+        }
+        // Blending straight alpha glyphs onto transparent black leaves premultiplied pixels
+        SDL_SetTextureBlendMode(composed.get(), SDL_BLENDMODE_BLEND_PREMULTIPLIED);
       }
+      SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+      SDL_SetRenderTarget(renderer, composed.get());
+      SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+      SDL_RenderClear(renderer);
+      drawText(0.0f, 0.0f);
+      SDL_SetRenderTarget(renderer, previous);
+    }
 
-      if (surf) {
-        texture.reset(SDL_CreateTextureFromSurface(renderer, surf.get()));
-        rect = layout((float)surf->w, (float)surf->h);
+    // Done once per text change: each glyph's measured column tops, placed where the layout put the glyph
+    void MeasureColumnTops(GlyphColumnTops &glyphs, int width) {
+      columnTops.assign(width, std::numeric_limits<float>::infinity());
+      int count = 0;
+      SdlPtr<TTF_SubString *, SDL_free> substrings(TTF_GetTextSubStringsForRange(ttfText.get(), 0, -1, &count));
+      if (!substrings) return;
+      for (int i = 0; i < count; ++i) {
+        const TTF_SubString &substring = *substrings.get()[i];
+        const char *utf8 = text.data() + substring.offset;
+        auto length = static_cast<size_t>(substring.length);
+        const GlyphColumnTops::Glyph &glyph = glyphs.Find(SDL_StepUTF8(&utf8, &length));
+        const int left = substring.rect.x + glyph.left;
+        const auto top = static_cast<float>(substring.rect.y + glyph.top);
+        const int from = std::max(0, left), to = std::min(width, left + static_cast<int>(glyph.columnTops.size()));
+        for (int x = from; x < to; ++x) columnTops[x] = std::min(columnTops[x], top + glyph.columnTops[x - left]);
       }
     }
 
+    void place(float x, float y) {
+      rect.x = x;
+      rect.y = y;
+    }
+
     void draw(SDL_Renderer *renderer) const {
-      if (!texture) return;
+      if (!visible()) return;
+      if (!composed) { // without a texture of its own the label is drawn from the glyph atlases every frame
+        drawText(rect.x, rect.y);
+        return;
+      }
+      const SDL_FRect dest = {rect.x, rect.y, extent.w, extent.h};
+      SDL_RenderTexture(renderer, composed.get(), &extent, &dest);
+    }
+
+    void drawText(float x, float y) const {
       // Shadow
-      SDL_SetTextureColorMod(texture.get(), 0, 0, 0);
-      SDL_SetTextureAlphaMod(texture.get(), 128);
-      SDL_FRect shadow = rect;
-      shadow.x += 1.0f;
-      shadow.y += 1.0f;
-      SDL_RenderTexture(renderer, texture.get(), nullptr, &shadow);
+      TTF_SetTextColor(ttfText.get(), 0, 0, 0, 128);
+      TTF_DrawRendererText(ttfText.get(), x + ShadowOffset, y + ShadowOffset);
       // Text
-      SDL_SetTextureColorMod(texture.get(), 255, 255, 255);
-      SDL_SetTextureAlphaMod(texture.get(), 255);
-      SDL_RenderTexture(renderer, texture.get(), nullptr, &rect);
+      TTF_SetTextColor(ttfText.get(), color.r, color.g, color.b, color.a);
+      TTF_DrawRendererText(ttfText.get(), x, y);
+    }
+  };
+
+  // A label composed from the digit atlas: changing its text rewrites vertices, never a texture
+  struct AtlasLabel {
+    std::string text;
+    SDL_FRect rect{}; // size from update(), position from place()
+    SDL_FColor color{};
+    std::vector<float> columnTops;
+    DigitAtlas::Quads quads;
+
+    AtlasLabel() {
+      columnTops.reserve(Config::screen_width);
+      quads.Reserve(2 * 5); // shadow and text of "hh:mm"
+    }
+
+    [[nodiscard]] bool visible() const { return !text.empty(); }
+
+    // Returns true when the label looks different and the screen needs a redraw
+    bool update(const DigitAtlas &atlas, std::string_view newText, SDL_FColor newColor) {
+      if (text == newText) return false;
+      text = newText;
+      color = newColor;
+      columnTops.clear();
+      rect.w = text.empty() ? 0.0f : static_cast<float>(atlas.Measure(text));
+      rect.h = text.empty() ? 0.0f : static_cast<float>(atlas.Height());
+      if (!text.empty()) atlas.ComposeColumnTops(text, columnTops);
+      place(atlas, rect.x, rect.y);
+      return true;
+    }
+
+    // The quads carry their position, so moving the label emits them again
+    void place(const DigitAtlas &atlas, float x, float y) {
+      rect.x = x;
+      rect.y = y;
+      quads.Clear();
+      if (text.empty()) return;
+      atlas.Emit(text, rect.x + 1.0f, rect.y + 1.0f, {0.0f, 0.0f, 0.0f, 0.5f}, quads); // shadow
+      atlas.Emit(text, rect.x, rect.y, color, quads);
     }
+
+    void draw(SDL_Renderer *renderer, const DigitAtlas &atlas) const { atlas.Draw(renderer, quads); }
   };
 
-  TextLabel timeLabel;
+  DigitAtlas digitAtlas;
+  // Digits resolved for a new output size, waiting for the main thread to upload them
+  std::mutex digitsMutex;
+  std::optional<DigitAtlas::Resolved> pendingDigits;
+  float requestedDigitScale = 1.0f; // main thread only
+  std::jthread digitResolver;       // after what it uses, so it is joined first
+  AtlasLabel timeLabel;
   TextLabel dateLabel;
   TextLabel weatherLabel;
   TextLabel adviceLabel;
 
+  // Date at the top, time in the middle, weather and advice hanging below it. The big font's line box has a lot of
+  // room under the digits, which the weather moves up into.
+  LabelLayout layout{Config::screen_width, Config::screen_height};
+  LabelLayout::Node dateNode = layout.Add(LabelLayout::Anchor::Top, 60.0f);
+  LabelLayout::Node timeNode = layout.Add(LabelLayout::Anchor::Middle, -20.0f);
+  LabelLayout::Node weatherNode = layout.Add(LabelLayout::Anchor::Below, -80.0f, timeNode);
+  LabelLayout::Node adviceNode = layout.Add(LabelLayout::Anchor::Below, 10.0f, weatherNode);
+
   void FetchBackgroundImage(std::stop_token stopToken) {
     while (!stopToken.stop_requested()) {
       try {
@@ -436,9 +4006,12 @@ private:
                 SDL_IOStream *io = SDL_IOFromConstMem(imgResp.text.data(), imgResp.text.size());
                 SurfacePtr loadedSurf(IMG_Load_IO(io, true));
                 if (loadedSurf) {
-                  std::lock_guard lock(bgImageLoaderMutex);
-                  pendingBgImage = std::move(loadedSurf);
-                  lastLoadedUrl = imgUrl;
+                  {
+                    std::lock_guard lock(bgImageLoaderMutex);
+                    pendingBgImage = std::move(loadedSurf);
+                    lastLoadedUrl = imgUrl;
+                  }
+                  WakeMainLoop();
                 }
               }
             }
@@ -447,10 +4020,7 @@ private:
       } catch (const std::exception &e) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Background image fetch failed: %s", e.what());
       }
-      std::mutex sleepMutex;             // We use a dummy mutex because the condition_variable's wait_for requires
-      std::unique_lock lock(sleepMutex); // a lock to wait on
-      std::condition_variable_any().wait_for(lock, stopToken, std::chrono::hours(4),
-                                             [&stopToken] { return stopToken.stop_requested(); });
+      clock.SleepFor(stopToken, std::chrono::hours(4));
     }
   }
 
@@ -486,8 +4056,11 @@ private:
           {
             std::scoped_lock lock(weatherMutex);
             weatherString = std::move(result);
+            weatherReport = wd.current_weather;
+            weatherVersion.fetch_add(1, std::memory_order_release);
             weatherFetched = true;
           }
+          WakeMainLoop();
         }
       } catch (const std::exception &e) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Weather fetch failed: %s", e.what());
@@ -498,13 +4071,14 @@ private:
         auto useFallback = [&]() { finalAdvice = getBasicAdvice(tempForLLM); };
         if (!apiKey.empty() && apiKey != "MISSING_KEY") {
           try {
+            const auto local = LocalTime::Get().Split(clock.Now());
             std::string prompt = std::format(
                 "I live in Amsterdam. Today is {}, the time is {} and the weather is: {} ({:.0f}C). "
                 "What should I wear? Please answer in one short sentence, in russian. "
                 "Only say what clothes I should wear, there's no need to mention city, current weather or time and "
                 "date. "
                 "Basically, just continue the phrase: You should wear..., without saying the 'you should wear' part.",
-                getCurrentDate(), getCurrentTime(), weatherDescForLLM, tempForLLM);
+                getCurrentDate(local), getCurrentTime(local), weatherDescForLLM, tempForLLM);
             json payload = {
                 {"model", "openai/gpt-oss-120b"},
                 {"max_tokens", 300},
@@ -541,74 +4115,381 @@ private:
         {
           std::lock_guard lock(adviceMutex);
           adviceString = finalAdvice;
+          adviceVersion.fetch_add(1, std::memory_order_release);
         }
+        WakeMainLoop();
       }
 
-      std::mutex sleepMutex;
-      std::unique_lock lock(sleepMutex);
-      std::condition_variable_any().wait_for(lock, stopToken,
-                                             std::chrono::minutes(5), // Fetch weather every 5 minutes
-                                             [&stopToken] { return stopToken.stop_requested(); });
+      clock.SleepFor(stopToken, std::chrono::minutes(5)); // Fetch weather every 5 minutes
     }
   }
 
   void UpdateTiming() {
-    Uint64 now = SDL_GetPerformanceCounter();
-    Uint64 diff = now - lastPerformanceCounter;
-    lastPerformanceCounter = now;
-    deltaTime = (double)diff / (double)SDL_GetPerformanceFrequency();
-    fps = 1.0 / deltaTime;
+    deltaTime = pacer.WaitForNextFrame();
+    fps = deltaTime > 0.0 ? 1.0 / deltaTime : 0.0;
+  }
+
+  // A 1080p gradient standing in for the Bing image, so RenderTextureCover has real scaling work to do
+  static SurfacePtr MakeSyntheticBackground(int variant) {
+    SurfacePtr bg(SDL_CreateSurface(1920, 1080, SDL_PIXELFORMAT_XRGB8888));
+    if (bg && SDL_LockSurface(bg.get())) {
+      const Uint32 blue = 0x40u + Uint32(variant * 37 % 128);
+      for (int y = 0; y < bg->h; ++y) {
+        auto *row = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(bg->pixels) + y * bg->pitch);
+        for (int x = 0; x < bg->w; ++x) {
+          row[x] = (Uint32(x * 255 / bg->w) << 16) | (Uint32(y * 255 / bg->h) << 8) | blue;
+        }
+      }
+      SDL_UnlockSurface(bg.get());
+    }
+    return bg;
+  }
+
+  bool StartBenchmark() {
+    // The SIMD snow kernel has to agree with the scalar reference before its timings mean anything
+    constexpr int verifySteps = 300;
+    const auto check = snow.VerifyKernel(verifySteps);
+    std::printf("snow kernel: %s, max deviation from scalar reference %.2g over %d steps, %zu mismatches\n",
+                SnowSystem::KernelName(), check.maxError, verifySteps, check.mismatches);
+    if (check.mismatches > 0) {
+      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Snow kernel disagrees with the scalar reference");
+      return false;
+    }
+    if (snow.GetMotion() == SnowSystem::Motion::Stateless) {
+      const auto rebase = snow.VerifyRebase(60.0);
+      std::printf("stateless snow: max jump across a rebase %.2g, %zu mismatches\n", rebase.maxError,
+                  rebase.mismatches);
+      if (rebase.mismatches > 0) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Stateless snow moves when its origin is rebased");
+        return false;
+      }
+    }
+    std::printf("snow backend: %s for %zu flakes\n", snow.GetBackendName(), snow.GetActiveCount());
+    for (const SnowSystem::CalibrationTier &tier : snow.GetCalibration()) {
+      if (tier.flakes == 0) continue;
+      std::printf("  %zu flakes: %s (", tier.flakes, SnowSystem::BackendNames[static_cast<size_t>(tier.best)]);
+      const char *separator = "";
+      for (size_t b = 0; b < SnowSystem::BackendNames.size(); ++b) {
+        if (tier.us[b] <= 0.0) continue;
+        std::printf("%s%s %.1f us", separator, SnowSystem::BackendNames[b], tier.us[b]);
+        separator = ", ";
+      }
+      std::printf(" per step)\n");
+    }
+    if (!weatherEffects.PrintMeasurements(verifySteps, 1.0f / Config::target_fps)) {
+      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "A weather particle loop disagrees with the scalar reference");
+      return false;
+    }
+    // What a resize costs: the resolve runs on its own thread, the upload on the main one. The last one measured is
+    // for the bench's own output, which the run then draws with.
+    std::printf("digit atlas per resize:");
+    const char *separator = " ";
+    for (const float wanted : {2.0f, OutputScale()}) {
+      const float scale = digitAtlas.RoundScale(wanted);
+      const Uint64 start = SDL_GetTicksNS();
+      std::optional<DigitAtlas::Resolved> digits = digitAtlas.Resolve(scale);
+      const Uint64 resolved = SDL_GetTicksNS();
+      if (!digits || !digitAtlas.Upload(renderer.get(), *digits)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Couldn't resolve the clock digits: %s", SDL_GetError());
+        return false;
+      }
+      std::printf("%s%.3gx (%zu pages, first %dx%d) resolve %.1f ms, upload %.1f ms", separator, scale,
+                  digits->pages.size(), digits->pages[0]->w, digits->pages[0]->h, (resolved - start) / 1e6,
+                  (SDL_GetTicksNS() - resolved) / 1e6);
+      separator = "; ";
+    }
+    std::printf("\n");
+
+    // Start just before local midnight so the run covers a minute flip and a date change
+    using namespace std::chrono;
+    const sys_seconds localStart = sys_days{year{2025} / December / 24} + hours{23} + minutes{59} + seconds{45};
+    clock.StartManual(localStart - LocalTime::Get().Split(localStart).offset);
+
+    // Stand-ins for the network data: canned strings and a synthetic background. The strings have room for every
+    // canned text, so the changes after the warm-up must not allocate.
+    weatherString.reserve(TextLabel::TextCapacity);
+    adviceString.reserve(TextLabel::TextCapacity);
+    weatherString = BenchWeatherTexts[0];
+    weatherReport = CurrentWeather{.temperature = -3.0, .windspeed = 7.0, .weathercode = 75};
+    adviceString = BenchAdviceTexts[0];
+    weatherVersion++;
+    adviceVersion++;
+    pendingBgImage = MakeSyntheticBackground(0);
+
+    minuteClock.Start(clock, {});
+    benchReport.Start(options.benchFrames);
+    return true;
+  }
+
+  // Every Config::bench_data_period frames after the warm-up, the next canned weather and advice texts arrive, so the
+  // allocation check also covers label updates, the layout and the snow obstacles
+  void FeedBenchmarkData() {
+    if (benchFramesDone <= Config::bench_warmup_frames || benchFramesDone % Config::bench_data_period != 0) return;
+    benchDataChanges++;
+    {
+      std::lock_guard lock(weatherMutex);
+      weatherString = BenchWeatherTexts[benchDataChanges % BenchWeatherTexts.size()];
+      weatherVersion++;
+    }
+    std::lock_guard lock(adviceMutex);
+    adviceString = BenchAdviceTexts[benchDataChanges % BenchAdviceTexts.size()];
+    adviceVersion++;
+  }
+
+  // Offline stand-in for both fetch threads during soak runs: the same cadence on the virtual clock, generated data
+  void FeedSyntheticData(std::stop_token stopToken) {
+    auto nextBackground = clock.Now();
+    // Cycles through snow, clouds (no particles), rain, fog and drizzle
+    constexpr std::array weathercodes{71, 3, 63, 45, 53};
+    for (int cycle = 0; !stopToken.stop_requested(); ++cycle) {
+      const double temperature = -8.0 + (cycle % 24);
+      const int weathercode = weathercodes[cycle % weathercodes.size()];
+      const double windspeed = cycle % 12;
+      {
+        std::scoped_lock lock(weatherMutex);
+        weatherString = std::format("{:.0f}°C, {}, {}", temperature, WEATHER_CODE_RU.at(weathercode),
+                                    getWindspeedType(windspeed));
+        weatherReport = CurrentWeather{.temperature = temperature, .windspeed = windspeed, .weathercode = weathercode};
+        weatherVersion.fetch_add(1, std::memory_order_release);
+      }
+      {
+        std::lock_guard lock(adviceMutex);
+        adviceString = getBasicAdvice(temperature);
+        adviceVersion.fetch_add(1, std::memory_order_release);
+      }
+      if (clock.Now() >= nextBackground) {
+        SurfacePtr bg = MakeSyntheticBackground(cycle);
+        std::lock_guard lock(bgImageLoaderMutex);
+        pendingBgImage = std::move(bg);
+        nextBackground += std::chrono::hours(4);
+      }
+      WakeMainLoop();
+      clock.SleepFor(stopToken, std::chrono::minutes(5));
+    }
+  }
+
+  SDL_AppResult FinishBenchmarkFrame() {
+    FrameProfiler::Frame frame;
+    if (profiler.ReadFrame(profiler.FramesWritten() - 1, frame)) {
+      benchReport.AddFrame(frame, Counters::allocations.load(std::memory_order_relaxed) - frameStartAllocations);
+    }
+    if (++benchFramesDone < options.benchFrames) return SDL_APP_CONTINUE;
+    const char *rendererName = SDL_GetRendererName(renderer.get());
+    benchReport.Print(rendererName ? rendererName : "?", options.seed.value_or(Config::bench_default_seed),
+                      Config::snow_enabled ? options.flakes : 0);
+    std::printf("weather and advice texts changed %d times after the warm-up\n", benchDataChanges);
+    std::printf("snow geometry: %.1f KiB written per frame, %.1f KiB submitted per draw\n",
+                snow.GeometryBytesWritten() / 1024.0, snow.GeometryBytesSubmitted() / 1024.0);
+    const double sprites = MeasureSnowDraw(true), quads = MeasureSnowDraw(false);
+    std::printf("snow draw: %.1f us with sprites, %.1f us as plain quads (%+.1f%%)\n", sprites, quads,
+                quads > 0.0 ? (sprites / quads - 1.0) * 100.0 : 0.0);
+    if (benchReport.SteadyAllocations() > 0) {
+      SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Frames after the warm-up allocated on the heap");
+      return SDL_APP_FAILURE;
+    }
+    return SDL_APP_SUCCESS;
+  }
+
+  // Median time in microseconds to draw the snow of the last frame and have the renderer finish it, over a few
+  // hundred draws. The frames are never presented.
+  double MeasureSnowDraw(bool textured) {
+    constexpr int draws = 301;
+    std::array<Uint64, draws> durations;
+    for (Uint64 &duration : durations) {
+      SDL_RenderClear(renderer.get());
+      SDL_FlushRenderer(renderer.get());
+      const Uint64 start = SDL_GetTicksNS();
+      snow.Draw(renderer.get(), textured);
+      SDL_FlushRenderer(renderer.get());
+      duration = SDL_GetTicksNS() - start;
+    }
+    std::ranges::nth_element(durations, durations.begin() + draws / 2);
+    return static_cast<double>(durations[draws / 2]) / 1e3;
+  }
 
-    SDL_Delay(16); // Wait for 16ms to maintain 60 FPS
+  void GovernQuality() {
+    FrameProfiler::Frame frame;
+    if (!profiler.ReadFrame(profiler.FramesWritten() - 1, frame)) return;
+    Uint64 costNs = frame.totalNs;
+    // With VSync, present blocks until the vblank; that is waiting, not work
+    if (pacer.GetMode() == FramePacer::Mode::VSync) {
+      costNs -= frame.durationNs[static_cast<size_t>(FrameProfiler::Stage::Present)];
+    }
+    if (!governor.AddFrame(static_cast<double>(costNs) / 1e6)) return;
+
+    const auto &level = governor.Current();
+    ApplyWeather();
+    if (bgTexture) SDL_SetTextureScaleMode(bgTexture.get(), level.backgroundScaleMode);
+    pacer.SetTargetRate(level.Fps());
+  }
+
+  // Shows the particles for the shown weather, scaled by its intensity and the quality level. Until the first report
+  // that is snow, as it always was.
+  void ApplyWeather() {
+    const WeatherScene scene = shownWeather ? getWeatherScene(shownWeather->weathercode) : WeatherScene{};
+    const float share = scene.intensity * governor.Current().snowFraction;
+    const float snowShare = scene.kind == WeatherScene::Kind::Snow ? share : 0.0f;
+    snow.SetActiveCount(static_cast<size_t>(std::lround(snowShare * static_cast<float>(snow.GetCapacity()))));
+    if (shownWeather) {
+      // The snow's own gusts are tuned for a moderate breeze
+      snow.SetWindScale(std::clamp(static_cast<float>(shownWeather->windspeed) / 5.0f, 0.2f, 3.0f));
+    }
+    weatherEffects.Set(scene.kind, share, shownWeather ? shownWeather->windspeed : 0.0);
+  }
+
+  // Safe to call from the data threads; the event itself carries nothing, it only ends WaitForDamage early
+  void WakeMainLoop() const {
+    if (wakeEventType == 0) return;
+    SDL_Event event{};
+    event.type = wakeEventType;
+    SDL_PushEvent(&event);
+  }
+
+  // Nothing is dirty: block until an event arrives or the minute (and thus the time label) rolls over
+  void WaitForDamage() {
+    auto now = clock.Now();
+    auto nextMinute = std::chrono::floor<std::chrono::minutes>(now) + std::chrono::minutes(1);
+    auto timeout = clock.RealDuration(nextMinute - now);
+    SDL_WaitEventTimeout(nullptr, static_cast<Sint32>(timeout.count()));
+    // Don't let the idle period show up as one giant frame once we start animating again
+    pacer.Resync();
   }
 
-  void UpdateTextures() {
+  // Returns true if anything visible changed since the last call
+  bool UpdateTextures() {
+    bool changed = false;
     SDL_Color white = {255, 255, 255, SDL_ALPHA_OPAQUE};
     { // Update Background Image
+      auto scope = profiler.Measure(FrameProfiler::Stage::Background);
       std::lock_guard lock(bgImageLoaderMutex);
       if (pendingBgImage) {
-        bgTexture.reset(SDL_CreateTextureFromSurface(renderer.get(), pendingBgImage.get()));
+        bgTexture.reset(CreateTextureFromSurface(renderer.get(), pendingBgImage.get()));
+        if (bgTexture) SDL_SetTextureScaleMode(bgTexture.get(), governor.Current().backgroundScaleMode);
         pendingBgImage.reset();
+        changed = true;
       }
     }
-    // Update Date
-    dateLabel.update(renderer.get(), fontNormal.get(), getCurrentDate(), white,
-                     [](float w, float h) { return SDL_FRect{(Config::screen_width - w) / 2.0f, 60.0f, w, h}; });
-    // Update Time
-    timeLabel.update(renderer.get(), fontBig.get(), getCurrentTime(), white, [](float w, float h) {
-      return SDL_FRect{(Config::screen_width - w) / 2.0f, (Config::screen_height - h) / 2.0f - 20.0f, w, h};
-    });
+    if (minuteClock.Poll() && options.soakDays > 0) {
+      soakReport.CheckLocalTime(minuteClock.Minute(), minuteClock.Time(), minuteClock.Date());
+    }
+    { // Update Date
+      auto scope = profiler.Measure(FrameProfiler::Stage::DateLabel);
+      changed |= dateLabel.update(renderer.get(), textEngine.get(), normalGlyphs, minuteClock.Date(), white);
+    }
+    { // Update Time, and the digits once they are resolved for a new output size
+      auto scope = profiler.Measure(FrameProfiler::Stage::TimeLabel);
+      if (std::lock_guard lock(digitsMutex); pendingDigits) {
+        if (!digitAtlas.Upload(renderer.get(), *pendingDigits)) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't upload the clock digits: %s", SDL_GetError());
+        }
+        pendingDigits.reset();
+        changed = true;
+      }
+      changed |= timeLabel.update(digitAtlas, minuteClock.Time(), {1.0f, 1.0f, 1.0f, 1.0f});
+    }
 
-    // Update Weather
-    std::string currentW;
-    {
+    // The strings of the data threads are only looked at when their version moved
+    if (const Uint64 version = weatherVersion.load(std::memory_order_acquire); version != shownWeatherVersion) {
+      auto scope = profiler.Measure(FrameProfiler::Stage::WeatherLabel);
       std::lock_guard lock(weatherMutex);
-      currentW = weatherString;
+      shownWeatherVersion = version;
+      if (weatherReport && (!shownWeather || weatherReport->weathercode != shownWeather->weathercode ||
+                            weatherReport->windspeed != shownWeather->windspeed)) {
+        shownWeather = weatherReport;
+        ApplyWeather();
+        changed = true;
+      }
+      changed |= weatherLabel.update(renderer.get(), textEngine.get(), normalGlyphs, weatherString, white);
+    }
+    if (const Uint64 version = adviceVersion.load(std::memory_order_acquire); version != shownAdviceVersion) {
+      auto scope = profiler.Measure(FrameProfiler::Stage::AdviceLabel);
+      std::lock_guard lock(adviceMutex);
+      shownAdviceVersion = version;
+      int wrapW = static_cast<int>(Config::screen_width * 0.95f);
+      changed |= adviceLabel.update(renderer.get(), textEngine.get(), smallGlyphs, adviceString, white, wrapW);
+    }
+    if (changed) {
+      LayOutLabels();
+      UpdateSnowObstacles();
+    }
+    return changed;
+  }
+
+  // Output pixels per logical pixel of the letterboxed screen
+  float OutputScale() const {
+    int w = 0, h = 0;
+    if (!SDL_GetRenderOutputSize(renderer.get(), &w, &h) || w <= 0 || h <= 0) return 1.0f;
+    return std::min(static_cast<float>(w) / Config::screen_width, static_cast<float>(h) / Config::screen_height);
+  }
+
+  // Resolves the big digits for as many output pixels as the letterboxed logical screen covers, so a larger panel
+  // gets sharper digits rather than scaled-up ones. That takes tens of milliseconds on the Pi, so it runs on a thread
+  // of its own and UpdateTextures() uploads the result; until then the digits are drawn from the previous texture.
+  void ScaleDigits() {
+    const float output = OutputScale(), scale = digitAtlas.RoundScale(output);
+    if (scale < output) {
+      SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Clock digits resolved at %.2fx for a %.2fx output: texture size limit",
+                  scale, output);
     }
-    weatherLabel.update(renderer.get(), fontNormal.get(), currentW, white, [&](float w, float h) {
-      float timeBottom = timeLabel.rect.y + timeLabel.rect.h;
-      // If time texture isn't ready yet, guess a position, otherwise use relative
-      float yPos = (timeBottom > 0) ? timeBottom - 80.0f : (Config::screen_height / 2.0f + 140.0f);
-      return SDL_FRect{(Config::screen_width - w) / 2.0f, yPos, w, h};
+    if (scale == requestedDigitScale) return;
+    requestedDigitScale = scale;
+    // Replacing the thread stops a resolve for an earlier size, which gives up at the next row, and joins it
+    digitResolver = std::jthread([this, scale](std::stop_token stopToken) {
+      std::optional<DigitAtlas::Resolved> resolved = digitAtlas.Resolve(scale, stopToken);
+      if (!resolved) {
+        if (!stopToken.stop_requested()) {
+          SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't resolve the clock digits at %.2fx: %s", scale,
+                      SDL_GetError());
+        }
+        return;
+      }
+      {
+        std::lock_guard lock(digitsMutex);
+        pendingDigits = std::move(resolved);
+      }
+      WakeMainLoop();
     });
+  }
 
-    std::string currentAdvice;
-    {
-      std::lock_guard lock(adviceMutex);
-      currentAdvice = adviceString;
+  // Feeds the label sizes to the layout and moves the labels whose rect it changed
+  void LayOutLabels() {
+    auto setSize = [&](LabelLayout::Node node, bool visible, const SDL_FRect &rect) {
+      layout.SetSize(node, visible ? rect.w : 0.0f, visible ? rect.h : 0.0f);
+    };
+    setSize(dateNode, dateLabel.visible(), dateLabel.rect);
+    setSize(timeNode, timeLabel.visible(), timeLabel.rect);
+    setSize(weatherNode, weatherLabel.visible(), weatherLabel.rect);
+    setSize(adviceNode, adviceLabel.visible(), adviceLabel.rect);
+    layout.Resolve([&](LabelLayout::Node node, const SDL_FRect &rect) {
+      if (node == timeNode) {
+        timeLabel.place(digitAtlas, rect.x, rect.y);
+      } else {
+        TextLabel &label = node == dateNode ? dateLabel : node == weatherNode ? weatherLabel : adviceLabel;
+        label.place(rect.x, rect.y);
+      }
+    });
+  }
+
+  void UpdateSnowObstacles() {
+    std::array<SnowCover::Obstacle, 4> obstacles;
+    size_t count = 0;
+    if (timeLabel.visible()) obstacles[count++] = {timeLabel.rect, timeLabel.columnTops};
+    for (const TextLabel *label : {&dateLabel, &weatherLabel, &adviceLabel}) {
+      if (label->visible()) obstacles[count++] = {label->rect, label->columnTops};
     }
-    int wrapW = static_cast<int>(Config::screen_width * 0.95f);
-    adviceLabel.update(
-        renderer.get(), fontSmall.get(), currentAdvice, white,
-        [&](float w, float h) {
-          float weatherBottom = weatherLabel.rect.y + weatherLabel.rect.h;
-          float yPos = weatherBottom + 10.0f; // 10px padding
-          return SDL_FRect{(Config::screen_width - w) / 2.0f, yPos, w, h};
-        },
-        wrapW);
+    snow.SetObstacles({obstacles.data(), count});
   }
 
   void Render() {
+    {
+      auto scope = profiler.Measure(FrameProfiler::Stage::Render);
+      DrawFrame();
+    }
+    auto scope = profiler.Measure(FrameProfiler::Stage::Present);
+    SDL_RenderPresent(renderer.get());
+  }
+
+  void DrawFrame() {
     SDL_SetRenderDrawColor(renderer.get(), 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderClear(renderer.get());
 
@@ -617,17 +4498,24 @@ private:
       RenderTextureCover(bgTexture.get());
     }
     snow.Draw(renderer.get());
+    weatherEffects.Draw(renderer.get());
     dateLabel.draw(renderer.get());
-    timeLabel.draw(renderer.get());
+    timeLabel.draw(renderer.get(), digitAtlas);
     weatherLabel.draw(renderer.get());
     adviceLabel.draw(renderer.get());
+    snow.DrawCover(renderer.get());
 
 #ifdef APP_DEBUG
     SDL_SetRenderDrawColor(renderer.get(), 255, 255, 255, SDL_ALPHA_OPAQUE);
     SDL_RenderDebugTextFormat(renderer.get(), 10, 10, "FPS: %.2f", fps);
+    const auto &pacing = pacer.GetStats();
+    SDL_RenderDebugTextFormat(renderer.get(), 10, 20, "Pacer: %s %.0f Hz, missed %llu, jitter %.2f ms",
+                              FramePacer::ModeName(pacer.GetMode()), pacer.GetTargetRate(),
+                              static_cast<unsigned long long>(pacing.missedDeadlines), pacing.jitterMs);
+    SDL_RenderDebugTextFormat(renderer.get(), 10, 30, "Quality: %s, %zu flakes (%s, %s), %zu other particles",
+                              governor.Current().name, snow.GetActiveCount(), SnowSystem::KernelName(),
+                              snow.GetBackendName(), weatherEffects.GetActiveCount());
 #endif
-
-    SDL_RenderPresent(renderer.get());
   }
 
   // Helper to simulate "CSS object-fit: cover"
@@ -645,7 +4533,7 @@ private:
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
   auto *app = new Clock();
-  if (!app->Init()) {
+  if (!app->Init(AppOptions::Parse(argc, argv))) {
     delete app;
     return SDL_APP_FAILURE;
   }
@@ -654,10 +4542,8 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 }
 
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
-  if (event->type == SDL_EVENT_QUIT) {
-    return SDL_APP_SUCCESS;
-  }
-  return SDL_APP_CONTINUE;
+  auto *app = static_cast<Clock *>(appstate);
+  return app->HandleEvent(event);
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {